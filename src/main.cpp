@@ -8,19 +8,42 @@
 
 #include <vector>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <cstdlib>
 #include <cmath>
+#include <climits>
 #include <algorithm>
 #include <memory>
+#include <array>
 #include <cassert>
 #include <chrono>
 #include <csignal>
+#include <atomic>
+#include <filesystem>
 
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <future>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#include <immintrin.h>
+#endif
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define HAS_IO_URING
+#undef BLOCK_SIZE // 由 <linux/fs.h> 间接引入，与本文件的 BLOCK_SIZE 同名
+#endif
 
 #include <plog/Log.h>
 #include <plog/Init.h>
@@ -31,32 +54,61 @@ using namespace std;
 #define dout PLOGD
 
 #define FILESYSTEM_NAME "file.sys"
-#define FILESYSTEM_SIZE (16 * 1024 * 1024) // 16MB
-#define BLOCK_SIZE (1024)
-#define INODE_SIZE (64)
-#define BLOCK_NUM (FILESYSTEM_SIZE / BLOCK_SIZE) // 16K
-#define INODE_NUM (BLOCK_NUM / 2)                // 8K
-#define MAX_FILE_SIZE ((NUM_DIRECT_BLOCK + NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK + NUM_DOUBLE_INDIRECT_BLOCK * ADDRESS_PER_BLOCK * ADDRESS_PER_BLOCK) * BLOCK_SIZE)
-// (10 + 512 + 512 * 512) KB = 262,666 KB
-#define MAX_FILENAME_SIZE (29)
+#define FILESYSTEM_VERSION (9) // 磁盘格式版本，格式不兼容时递增
+
+// 镜像几何参数在运行时决定（见 Geometry），以下宏展开为当前镜像的参数，括号内为默认值
+#define FILESYSTEM_SIZE (geometry.filesystem_size) // 16MB
+#define BLOCK_SIZE (geometry.block_size)           // 1KB
+#define INODE_SIZE (128)
+#define BLOCK_NUM (geometry.block_num)         // 16K
+#define INODE_NUM (geometry.inode_num)         // 8K
+#define MAX_FILE_SIZE (geometry.max_file_size) // (10 + 512 + 512 * 512) KB = 262,666 KB
+#define DEFAULT_BYTES_PER_INODE (2 * 1024)      // mkfs 未指定时每 2KB 镜像空间一个 INode
+#define MAX_FILENAME_SIZE (28)
+#define INLINE_DATA_SIZE (64) // 不超过该大小的文件内容直接存放在 INode 中，不占用数据块
+
+// 尾部打包：文件最后不足一块的片段与其他文件的片段共用一个打包块
+#define TAIL_SLOT_SIZE (geometry.tail_slot_size)    // 打包块内按槽位分配，64 Byte
+#define TAIL_SLOT_NUM (BLOCK_SIZE / TAIL_SLOT_SIZE) // 16，不超过 32，以放入 slot_mask
+#define TAIL_PACK_MAX_SIZE (BLOCK_SIZE / 2)         // 超过该大小的尾部片段仍使用独立数据块
+
+// 透明压缩：文件内容均为小写字母，每个字母编码为 5 位，8 个逻辑块的内容压缩后存入 5 个数据块
+#define PACK_GROUP_SIZE (8)  // 每组的字母数
+#define PACK_GROUP_BYTES (5) // 每组压缩后的字节数
 
 // 目录项 Directory Entry
 #define DENTRY_SIZE (32)                                // 32 Byte
 #define DENTRY_NUM_PER_BLOCK (BLOCK_SIZE / DENTRY_SIZE) // 32
+#define DIR_COMPACT_THRESHOLD (4)                       // 目录项占用率低于 1/4 时自动压缩目录
+
+// 目录项 Bloom 过滤器
+#define BLOOM_MIN_BLOCK_NUM (4)   // Dentry 块数达到该值的目录才使用过滤器
+#define BLOOM_BITS_PER_ENTRY (10) // 每个目录项占用的位数
+#define BLOOM_HASH_NUM (7)        // 哈希函数个数，与每项 10 位搭配时误报率约 1%
 
 // 组织结构
-#define SUPERBLOCK_SIZE (1 * 1024)                // 1KB
-#define BLOCK_BITMAP_SIZE (BLOCK_NUM / 8)         // 2KB
-#define INODE_BITMAP_SIZE (INODE_NUM / 8)         // 1KB
-#define INODE_TABLE_SIZE (INODE_NUM * INODE_SIZE) // 512KB
+#define SUPERBLOCK_SIZE (1 * 1024)                       // 1KB
+#define BLOCK_BITMAP_SIZE (geometry.block_bitmap_size)   // 2KB
+#define INODE_BITMAP_SIZE (geometry.inode_bitmap_size)   // 1KB
+#define INODE_TABLE_SIZE (geometry.inode_table_size)     // 1MB
+#define JOURNAL_SIZE (geometry.journal_size)             // 512KB
+#define CHECKSUM_SIZE (geometry.checksum_size)           // 64KB，每块一个 CRC32C
 
 #define SUPERBLOCK_START (0)
 #define BLOCK_BITMAP_START (SUPERBLOCK_START + SUPERBLOCK_SIZE)     // 1KB
 #define INODE_BITMAP_START (BLOCK_BITMAP_START + BLOCK_BITMAP_SIZE) // 3KB
 #define INODE_TABLE_START (INODE_BITMAP_START + INODE_BITMAP_SIZE)  // 4KB
-#define BLOCK_START (INODE_TABLE_START + INODE_TABLE_SIZE)          // 516KB
+#define JOURNAL_START (geometry.journal_start)                      // 1028KB，按块对齐
+#define CHECKSUM_START (JOURNAL_START + JOURNAL_SIZE)                // 1540KB
+#define BLOCK_START (CHECKSUM_START + CHECKSUM_SIZE)                 // 1604KB
+
+#define DATA_BLOCK_NUM (geometry.data_block_num) // 14780
 
-#define DATA_BLOCK_NUM ((FILESYSTEM_SIZE - BLOCK_START) / BLOCK_SIZE)
+// 分配组：将数据块与 INode 划分为若干区域，相关的 INode 与数据块尽量分配在同一组内
+// 各组按 bitmap 字节对齐，互不共享 bitmap 字节
+#define GROUP_NUM (16)
+#define BLOCKS_PER_GROUP (geometry.blocks_per_group) // 928，最后一组略少
+#define INODES_PER_GROUP (INODE_NUM / GROUP_NUM)     // 512
 
 // 地址长度
 #define ADDRESS_SIZE (2)                              // 实际使用 14 位
@@ -65,6 +117,27 @@ using namespace std;
 #define NUM_INDIRECT_BLOCK (1)
 #define NUM_DOUBLE_INDIRECT_BLOCK (1)
 
+// 元数据日志
+#define JOURNAL_BLOCK_NUM (JOURNAL_SIZE / BLOCK_SIZE) // 512，第一个块为日志头
+#define JOURNAL_MIN_BLOCK_NUM (64)                    // 块较大时日志区至少容纳的块数
+#define JOURNAL_MAGIC (0x4C4E524A)                   // "JRNL"
+#define JOURNAL_GROUP_COMMIT_NUM (16)                 // 累计多少个事务后一并提交
+#define JOURNAL_COMMIT_BLOCK_NUM ((JOURNAL_BLOCK_NUM - 1) / 2) // 待提交的元数据块达到多少时提前提交，留出校验和区块与描述块的余量
+
+// 块校验和：镜像中每个块（日志区与校验和区除外）在校验和区中有一个 CRC32C，块写回原位置时更新，读取时校验
+#define CRC32C_POLY (0x82F63B78) // Castagnoli 多项式（反射形式）
+
+// 块 I/O 后端
+#define IO_QUEUE_DEPTH (64) // io_uring 提交队列长度，即一次系统调用最多同时发出的请求数
+
+// 顺序预读
+#define READAHEAD_MIN_BLOCK_NUM (4)   // 初始窗口与随机访问时的窗口大小
+#define READAHEAD_MAX_BLOCK_NUM (256) // 顺序访问时窗口逐次翻倍，至多 256KB
+
+// 后台回写
+#define FLUSH_INTERVAL_MS (1000)             // 回写线程的默认唤醒间隔
+#define FLUSH_DIRTY_THRESHOLD (1024 * 1024) // 脏块超过该字节数时立即唤醒回写线程
+
 #define ROOT_INODE_ID (0)
 
 #define RESET "\e[0m"
@@ -89,6 +162,76 @@ ostream &operator<<(ostream &os, const vector<T> &vec)
     return os;
 }
 
+// 镜像几何参数：镜像大小、块大小与 INode 数由 mkfs 指定并写入超级块，加载时由超级块恢复，其余布局均由此推导
+// 块 ID 与 INode ID 均为 short，数据块数与 INode 数不超过 32767
+struct Geometry
+{
+    int filesystem_size = 16 * 1024 * 1024;
+    int block_size = 1024;
+    int inode_num = filesystem_size / DEFAULT_BYTES_PER_INODE;
+
+    // 推导出的布局
+    int block_num;
+    int block_bitmap_size;
+    int inode_bitmap_size;
+    int inode_table_size;
+    int journal_size;
+    int checksum_size;
+    int journal_start;
+    int data_block_num;
+    int blocks_per_group;
+    int max_file_size;
+    int tail_slot_size;
+
+    Geometry()
+    {
+        derive();
+    }
+
+    Geometry(const int &filesystem_size, const int &block_size, const int &inode_num)
+        : filesystem_size(filesystem_size), block_size(block_size), inode_num(inode_num)
+    {
+        derive();
+    }
+
+    void derive()
+    {
+        block_num = filesystem_size / block_size;
+        block_bitmap_size = block_num / 8;
+        inode_bitmap_size = inode_num / 8;
+        inode_table_size = inode_num * INODE_SIZE;
+        journal_size = max(512 * 1024, JOURNAL_MIN_BLOCK_NUM * block_size);
+        checksum_size = (block_num * (int)sizeof(uint32_t) + block_size - 1) / block_size * block_size;
+        const int inode_table_end = SUPERBLOCK_START + SUPERBLOCK_SIZE + block_bitmap_size + inode_bitmap_size + inode_table_size;
+        journal_start = (inode_table_end + block_size - 1) / block_size * block_size;
+        data_block_num = (filesystem_size - journal_start - journal_size - checksum_size) / block_size;
+        blocks_per_group = ((data_block_num + GROUP_NUM - 1) / GROUP_NUM + 7) / 8 * 8;
+        const int64_t address_num = block_size / ADDRESS_SIZE;
+        max_file_size = min<int64_t>((NUM_DIRECT_BLOCK + NUM_INDIRECT_BLOCK * address_num + NUM_DOUBLE_INDIRECT_BLOCK * address_num * address_num) * block_size, INT_MAX);
+        tail_slot_size = max(64, block_size / 32);
+    }
+
+    // 参数不可用时返回原因
+    string validate() const
+    {
+        if (block_size < 1024 || block_size > 16 * 1024 || (block_size & (block_size - 1)))
+            return "block size must be a power of two between 1K and 16K";
+        if (filesystem_size % (8 * block_size))
+            return "image size must be a multiple of 8 blocks";
+        if (inode_num < 8 * GROUP_NUM || inode_num > SHRT_MAX || inode_num % (8 * GROUP_NUM))
+            return "inode count must be a multiple of " + to_string(8 * GROUP_NUM) + " between " + to_string(8 * GROUP_NUM) + " and " + to_string(SHRT_MAX / (8 * GROUP_NUM) * (8 * GROUP_NUM));
+        if (data_block_num < 8 * GROUP_NUM)
+            return "image too small for its metadata";
+        if (data_block_num > SHRT_MAX)
+            return "too many data blocks (" + to_string(data_block_num) + "), use a larger block size";
+        return "";
+    }
+};
+
+Geometry geometry; // 当前镜像的几何参数
+
+string image_path = FILESYSTEM_NAME; // 镜像文件路径，可由启动参数 image 指定，回放时默认使用临时镜像
+
 class Util
 {
 public:
@@ -113,20 +256,148 @@ public:
     }
 
     // 根据文件大小计算需要使用的块数量
-    static const int block_occupation(int filesize_kb)
+    // 打包存放的尾部片段大小，0 表示没有（内联文件、大小为整块或片段过大）
+    static const int tail_size(const int &file_size)
+    {
+        const int tail = file_size % BLOCK_SIZE;
+        return file_size > INLINE_DATA_SIZE && tail <= TAIL_PACK_MAX_SIZE ? tail : 0;
+    }
+
+    // 不占用独立数据块的内容大小：内联文件为全部内容，其余为打包存放的尾部片段
+    static const int rest_size(const int &file_size)
+    {
+        return file_size <= INLINE_DATA_SIZE ? file_size : tail_size(file_size);
+    }
+
+    // 文件内容占用的独立数据块数，内联内容与打包的尾部片段不计入；压缩文件按压缩后的字节数计算
+    static const int data_block_num(const int &file_size, const bool &compressed = false)
+    {
+        const int size = file_size - rest_size(file_size);
+        return ((compressed ? packed_size(size) : size) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    }
+
+    // size 字节的内容压缩后的字节数（最后不足一组的部分按整组计）
+    static const int packed_size(const int &size)
     {
-        short num_indirect_block = filesize_kb > NUM_DIRECT_BLOCK * BLOCK_SIZE / 1024 ? 1 : 0;
-        short num_double_indirect_block = filesize_kb > NUM_DIRECT_BLOCK * BLOCK_SIZE / 1024 + NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK * BLOCK_SIZE / 1024 ? 1 : 0;
-        short num_2nd_indirect_block = ceil(float(filesize_kb - NUM_DIRECT_BLOCK * BLOCK_SIZE / 1024 - NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK * BLOCK_SIZE / 1024) / (ADDRESS_PER_BLOCK * BLOCK_SIZE / 1024));
+        return (size + PACK_GROUP_SIZE - 1) / PACK_GROUP_SIZE * PACK_GROUP_BYTES;
+    }
+
+    // 内容是否均为小写字母（压缩文件只能存放小写字母）
+    static bool is_packable(const string &data)
+    {
+        return all_of(data.begin(), data.end(), [](char c)
+                      { return c >= 'a' && c <= 'z'; });
+    }
+
+    // 压缩 group_num 组字母：每组 8 个字母的 5 位编码拼成 40 位，按小端序写入 5 字节
+    // 一组 8 个字母作为一个 64 位整数整体处理（各字节同时减去 'a'，再逐步把相邻字段合并），不逐字节循环
+    static void pack_letters(const char *src, const int &group_num, char *dst)
+    {
+        for (int group = 0; group < group_num; group++, src += PACK_GROUP_SIZE, dst += PACK_GROUP_BYTES)
+        {
+            uint64_t bytes;
+            memcpy(&bytes, src, PACK_GROUP_SIZE);
+            bytes = (bytes - 0x6161616161616161ULL) & 0x1F1F1F1F1F1F1F1FULL;
+            bytes = (bytes & 0x001F001F001F001FULL) | (bytes >> 3 & 0x03E003E003E003E0ULL);  // 每 16 位 10 个有效位
+            bytes = (bytes & 0x000003FF000003FFULL) | (bytes >> 6 & 0x000FFC00000FFC00ULL);  // 每 32 位 20 个有效位
+            bytes = (bytes & 0x00000000000FFFFFULL) | (bytes >> 12 & 0x000000FFFFF00000ULL); // 共 40 个有效位
+            memcpy(dst, &bytes, PACK_GROUP_BYTES);
+        }
+    }
+
+    // 解压 group_num 组字母，与 pack_letters 互逆；支持 AVX2 的 x86-64 处理器先以每次 4 组向量化解压，余下的组逐组处理
+    // 除最后一组外直接读取 8 字节再截取低 40 位，避免 5 字节拼接造成的存储转发停顿
+    // dst 可以与 src 重叠（原地解压）：每组写入 8 字节、读取 5 字节，src 领先 dst 不少于 3 * group_num + 12 字节时不会覆盖尚未读取的数据
+    static void unpack_letters(const char *src, int group_num, char *dst)
+    {
+#if defined(__x86_64__)
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        if (avx2)
+        {
+            const int done = _unpack_letters_avx2(src, group_num, dst);
+            src += done * PACK_GROUP_BYTES;
+            dst += done * PACK_GROUP_SIZE;
+            group_num -= done;
+        }
+#endif
+        for (int group = 0; group < group_num; group++, src += PACK_GROUP_BYTES, dst += PACK_GROUP_SIZE)
+        {
+            uint64_t bytes = 0;
+            if (group + 1 < group_num)
+            {
+                memcpy(&bytes, src, sizeof(bytes));
+                bytes &= 0xFFFFFFFFFFULL;
+            }
+            else
+                memcpy(&bytes, src, PACK_GROUP_BYTES);
+            bytes = (bytes & 0x00000000000FFFFFULL) | (bytes << 12 & 0x000FFFFF00000000ULL);
+            bytes = (bytes & 0x000003FF000003FFULL) | (bytes << 6 & 0x03FF000003FF0000ULL);
+            bytes = (bytes & 0x001F001F001F001FULL) | (bytes << 3 & 0x1F001F001F001F00ULL);
+            bytes += 0x6161616161616161ULL;
+            memcpy(dst, &bytes, PACK_GROUP_SIZE);
+        }
+    }
+
+#if defined(__x86_64__)
+    // 每次解压 4 组：两组 10 字节广播到两个 128 位通道，各通道按组内位置把每个字母所在的 2 字节取为一个 16 位字，
+    // 乘以 2^(11 - 起始位) 左移后再右移 11 位得到 5 位编码，两次结果合并为字节并恢复组的顺序
+    // 每次读取 26 字节，最后两组留给逐组处理以免读出压缩数据末尾，返回解压的组数
+    __attribute__((target("avx2"))) static int _unpack_letters_avx2(const char *src, const int &group_num, char *dst)
+    {
+        const __m256i shuffle = _mm256_setr_epi8(0, 1, 0, 1, 1, 2, 1, 2, 2, 3, 3, 4, 3, 4, 4, 5,
+                                                 5, 6, 5, 6, 6, 7, 6, 7, 7, 8, 8, 9, 8, 9, 9, 10);
+        const __m256i multiplier = _mm256_setr_epi16(1 << 11, 1 << 6, 1 << 9, 1 << 4, 1 << 7, 1 << 10, 1 << 5, 1 << 8,
+                                                     1 << 11, 1 << 6, 1 << 9, 1 << 4, 1 << 7, 1 << 10, 1 << 5, 1 << 8);
+        const __m256i letter_a = _mm256_set1_epi8('a');
+        int group = 0;
+        for (; group + 4 <= group_num - 2; group += 4, src += 4 * PACK_GROUP_BYTES, dst += 4 * PACK_GROUP_SIZE)
+        {
+            __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)src));
+            __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(src + 2 * PACK_GROUP_BYTES)));
+            low = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(low, shuffle), multiplier), 11);
+            high = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(high, shuffle), multiplier), 11);
+            const __m256i letters = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+            _mm256_storeu_si256((__m256i *)dst, _mm256_add_epi8(letters, letter_a));
+        }
+        return group;
+    }
+#endif
+
+    // 解析文件大小参数（返回字节数）：纯数字或以 K / KB 结尾时单位为 KB，以 M / MB 结尾时单位为 MB，以 B 结尾时单位为字节
+    static const int parse_size(const string &str)
+    {
+        size_t unit_pos = 0;
+        const long long value = stoll(str, &unit_pos);
+        const string unit = str.substr(unit_pos);
+        long long size;
+        if (unit.empty() || unit == "K" || unit == "k" || unit == "KB" || unit == "kb")
+            size = value * 1024;
+        else if (unit == "M" || unit == "m" || unit == "MB" || unit == "mb")
+            size = value * 1024 * 1024;
+        else if (unit == "B" || unit == "b")
+            size = value;
+        else
+            throw invalid_argument("invalid size unit: " + unit);
+        if (size > INT_MAX || size < INT_MIN)
+            throw out_of_range("size out of range: " + str);
+        return size;
+    }
+
+    // data_block_num 个数据块连同所需的间接地址块共占用的块数
+    static const int block_occupation(int data_block_num)
+    {
+        short num_indirect_block = data_block_num > NUM_DIRECT_BLOCK ? 1 : 0;
+        short num_double_indirect_block = data_block_num > NUM_DIRECT_BLOCK + NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK ? 1 : 0;
+        short num_2nd_indirect_block = ceil(float(data_block_num - NUM_DIRECT_BLOCK - NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK) / ADDRESS_PER_BLOCK);
         if (num_2nd_indirect_block < 0)
             num_2nd_indirect_block = 0;
-        dout << "filesize_kb: " << filesize_kb << " num_indirect_block: " << num_indirect_block << " num_double_indirect_block: " << num_double_indirect_block << " num_2nd_indirect_block: " << num_2nd_indirect_block << endl;
-        return filesize_kb + num_indirect_block + num_double_indirect_block + num_2nd_indirect_block;
+        dout << "data_block_num: " << data_block_num << " num_indirect_block: " << num_indirect_block << " num_double_indirect_block: " << num_double_indirect_block << " num_2nd_indirect_block: " << num_2nd_indirect_block << endl;
+        return data_block_num + num_indirect_block + num_double_indirect_block + num_2nd_indirect_block;
     }
 
-    static const string readable_size(const int size)
+    static const string readable_size(const int64_t size)
     {
-        vector<string> suffix = {"", "K", "M"};
+        vector<string> suffix = {"", "K", "M", "G"};
         double _new_size = size;
         int _suffix_idx = 0;
 
@@ -147,6 +418,88 @@ public:
         return ss.str() + suffix[_suffix_idx];
     }
 
+    // FNV-1a 64 位哈希，seed 用于串联多段数据
+    static uint64_t fnv1a(const void *data, size_t size, uint64_t seed = 14695981039346656037ULL)
+    {
+        const unsigned char *bytes = (const unsigned char *)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            seed ^= bytes[i];
+            seed *= 1099511628211ULL;
+        }
+        return seed;
+    }
+
+    // CRC32C：支持 SSE4.2 的 x86-64 处理器使用 crc32 指令，其余情况按 8 字节分片查表计算
+    static uint32_t crc32c(const void *data, size_t size, uint32_t crc = 0)
+    {
+#if defined(__x86_64__)
+        if (crc32c_hardware())
+            return _crc32c_hardware((const unsigned char *)data, size, crc);
+#endif
+        return _crc32c_software((const unsigned char *)data, size, crc);
+    }
+
+    static bool crc32c_hardware()
+    {
+#if defined(__x86_64__)
+        static const bool hardware = __builtin_cpu_supports("sse4.2");
+        return hardware;
+#else
+        return false;
+#endif
+    }
+
+#if defined(__x86_64__)
+    __attribute__((target("sse4.2"))) static uint32_t _crc32c_hardware(const unsigned char *bytes, size_t size, uint32_t crc)
+    {
+        uint64_t crc64 = ~crc;
+        for (; size >= 8; bytes += 8, size -= 8)
+        {
+            uint64_t word;
+            memcpy(&word, bytes, 8);
+            crc64 = _mm_crc32_u64(crc64, word);
+        }
+        crc = crc64;
+        for (; size > 0; bytes++, size--)
+            crc = _mm_crc32_u8(crc, *bytes);
+        return ~crc;
+    }
+#endif
+
+    static uint32_t _crc32c_software(const unsigned char *bytes, size_t size, uint32_t crc)
+    {
+        // table[k][i] 为字节 i 之后再跟 k 个零字节时的 CRC
+        static const auto table = []
+        {
+            vector<array<uint32_t, 256>> table(8);
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t c = i;
+                for (int bit = 0; bit < 8; bit++)
+                    c = c & 1 ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+                table[0][i] = c;
+            }
+            for (int k = 1; k < 8; k++)
+                for (int i = 0; i < 256; i++)
+                    table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+            return table;
+        }();
+
+        crc = ~crc;
+        for (; size >= 8; bytes += 8, size -= 8)
+        {
+            uint64_t word;
+            memcpy(&word, bytes, 8);
+            word ^= crc;
+            crc = table[7][word & 0xFF] ^ table[6][word >> 8 & 0xFF] ^ table[5][word >> 16 & 0xFF] ^ table[4][word >> 24 & 0xFF] ^
+                  table[3][word >> 32 & 0xFF] ^ table[2][word >> 40 & 0xFF] ^ table[1][word >> 48 & 0xFF] ^ table[0][word >> 56];
+        }
+        for (; size > 0; bytes++, size--)
+            crc = table[0][(crc ^ *bytes) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
     static bool ends_with(const string &str, const string &suffix)
     {
         if (str.length() < suffix.length())
@@ -188,18 +541,192 @@ public:
     }
 };
 
+// 追踪事件（Chrome Trace Event Format 中的 B/E 事件）
+struct TraceEvent
+{
+    const char *name; // 必须为字符串字面量，记录时不做拷贝
+    char phase;       // 'B' 开始，'E' 结束
+    int64_t ts_ns;    // 相对于追踪器启动时刻的纳秒数
+};
+
+// 操作追踪器：默认关闭，开启后各线程把 begin/end 事件写入自己的缓冲区，退出时或按需导出为 Chrome Trace JSON
+class Tracer
+{
+public:
+    static constexpr int CHUNK_EVENT_NUM = 16 * 1024;
+
+    // 单个线程的事件缓冲区由若干定长分块串成链表，写入时无需加锁，导出时按已发布的 size 读取
+    struct Chunk
+    {
+        TraceEvent events[CHUNK_EVENT_NUM];
+        atomic<int> size{0};
+        atomic<Chunk *> next{nullptr};
+    };
+
+    struct ThreadBuffer
+    {
+        int tid;
+        Chunk *head;
+        Chunk *tail;
+    };
+
+    static bool is_enabled()
+    {
+        return enabled().load(memory_order_relaxed);
+    }
+
+    static void enable(bool flag = true)
+    {
+        enabled().store(flag, memory_order_relaxed);
+    }
+
+    static void record(const char *name, char phase)
+    {
+        ThreadBuffer &buffer = local_buffer();
+        Chunk *chunk = buffer.tail;
+        int size = chunk->size.load(memory_order_relaxed);
+        if (size == CHUNK_EVENT_NUM)
+        {
+            Chunk *new_chunk = new Chunk();
+            chunk->next.store(new_chunk, memory_order_release);
+            buffer.tail = chunk = new_chunk;
+            size = 0;
+        }
+        chunk->events[size] = {name, phase, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch()).count()};
+        chunk->size.store(size + 1, memory_order_release);
+    }
+
+    // 导出目前为止记录的所有事件，返回导出的事件数
+    static int dump(const string &path)
+    {
+        ofstream file(path, ios::out | ios::trunc);
+        if (!file)
+            return -1;
+
+        int event_num = 0;
+        file << "{\"traceEvents\":[";
+        lock_guard<mutex> lock(registry_mutex());
+        for (const ThreadBuffer *buffer : registry())
+            for (const Chunk *chunk = buffer->head; chunk != nullptr; chunk = chunk->next.load(memory_order_acquire))
+            {
+                int size = chunk->size.load(memory_order_acquire);
+                for (int i = 0; i < size; i++)
+                {
+                    const TraceEvent &event = chunk->events[i];
+                    file << (event_num++ ? ",\n" : "\n");
+                    file << "{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase << "\",\"ts\":" << fixed << setprecision(3) << event.ts_ns / 1000.0 << ",\"pid\":1,\"tid\":" << buffer->tid << "}";
+                }
+            }
+        file << "\n],\"displayTimeUnit\":\"ms\"}" << endl;
+        return event_num;
+    }
+
+    // 进程退出时导出到 path（由 atexit 调用）
+    static void dump_at_exit(const string &path)
+    {
+        exit_dump_path() = path;
+        static bool registered = false;
+        if (!registered)
+        {
+            registered = true;
+            atexit([]
+                   {
+                int event_num = dump(exit_dump_path());
+                if (event_num >= 0)
+                    cout << "[Trace] " << event_num << " events written to " << exit_dump_path() << endl; });
+        }
+    }
+
+private:
+    static atomic<bool> &enabled()
+    {
+        static atomic<bool> flag(false);
+        return flag;
+    }
+
+    static chrono::steady_clock::time_point epoch()
+    {
+        static const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        return start;
+    }
+
+    // 以下静态对象刻意不析构，保证 atexit 导出时仍然可用
+    static mutex &registry_mutex()
+    {
+        static mutex *mtx = new mutex();
+        return *mtx;
+    }
+
+    static vector<ThreadBuffer *> &registry()
+    {
+        static vector<ThreadBuffer *> *buffers = new vector<ThreadBuffer *>();
+        return *buffers;
+    }
+
+    static string &exit_dump_path()
+    {
+        static string *path = new string("trace.json");
+        return *path;
+    }
+
+    // 每个线程首次记录时注册一次缓冲区（仅此处加锁），缓冲区在进程生命周期内不释放
+    static ThreadBuffer &local_buffer()
+    {
+        thread_local ThreadBuffer *buffer = nullptr;
+        if (buffer == nullptr)
+        {
+            Chunk *chunk = new Chunk();
+            lock_guard<mutex> lock(registry_mutex());
+            buffer = new ThreadBuffer{int(registry().size()) + 1, chunk, chunk};
+            registry().push_back(buffer);
+        }
+        return *buffer;
+    }
+};
+
+// 作用域追踪：构造时记录开始，析构时记录结束；追踪关闭时仅有一次原子读
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name)
+        : name(Tracer::is_enabled() ? name : nullptr)
+    {
+        if (this->name)
+            Tracer::record(this->name, 'B');
+    }
+
+    ~TraceScope()
+    {
+        if (name)
+            Tracer::record(name, 'E');
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(_trace_scope_, __LINE__)(name)
+
 class SuperBlock
 {
 public:
-    const int filesystem_size = FILESYSTEM_SIZE; // 文件系统大小（Byte）
-    const int block_size = BLOCK_SIZE;           // 块（block）的大小（Byte）
-    const int block_num = BLOCK_NUM;             // 块（block）的数量
-    const int data_block_num = DATA_BLOCK_NUM;   // 数据块的数量
-    const int inode_size = INODE_SIZE;           // INode 的大小（Byte）
-    const int inode_num = INODE_NUM;             // INode 的数量
+    // 格式化时的几何参数，加载镜像时据此恢复
+    int filesystem_size = FILESYSTEM_SIZE; // 文件系统大小（Byte）
+    int block_size = BLOCK_SIZE;           // 块（block）的大小（Byte）
+    int block_num = BLOCK_NUM;             // 块（block）的数量
+    int data_block_num = DATA_BLOCK_NUM;   // 数据块的数量
+    int inode_size = INODE_SIZE;           // INode 的大小（Byte）
+    int inode_num = INODE_NUM;             // INode 的数量
 
     int available_block_num = (FILESYSTEM_SIZE - BLOCK_START) / BLOCK_SIZE; // 可用块的数量
     int available_inode_num = INODE_NUM;                                    // 可用 INode 的数量
+    int version = FILESYSTEM_VERSION;                                       // 磁盘格式版本（旧镜像此处为 0）
+    int mount_state = 0;                                                    // 1 表示已挂载、尚未正常卸载，启动时据此决定是否检查（旧镜像此处为 0）
 
     SuperBlock()
     {
@@ -242,33 +769,48 @@ public:
 
     // 复制构造函数
     SuperBlock(const SuperBlock &superblock)
-        : filesystem_size(superblock.filesystem_size), block_size(superblock.block_size), block_num(superblock.block_num), data_block_num(superblock.data_block_num), inode_size(superblock.inode_size), inode_num(superblock.inode_num), available_block_num(superblock.available_block_num), available_inode_num(superblock.available_inode_num)
+        : filesystem_size(superblock.filesystem_size), block_size(superblock.block_size), block_num(superblock.block_num), data_block_num(superblock.data_block_num), inode_size(superblock.inode_size), inode_num(superblock.inode_num), available_block_num(superblock.available_block_num), available_inode_num(superblock.available_inode_num), version(superblock.version), mount_state(superblock.mount_state)
     {
     }
 
     // 赋值运算符重载
     SuperBlock &operator=(const SuperBlock &superblock)
     {
+        this->filesystem_size = superblock.filesystem_size;
+        this->block_size = superblock.block_size;
+        this->block_num = superblock.block_num;
+        this->data_block_num = superblock.data_block_num;
+        this->inode_size = superblock.inode_size;
+        this->inode_num = superblock.inode_num;
         this->available_block_num = superblock.available_block_num;
         this->available_inode_num = superblock.available_inode_num;
+        this->version = superblock.version;
+        this->mount_state = superblock.mount_state;
         return *this;
     }
+
+    // 超级块中记录的几何参数
+    Geometry to_geometry() const
+    {
+        return Geometry(filesystem_size, block_size, inode_num);
+    }
 };
 
 class Dentry
 {
 public:
     short inode_id;
+    char file_type;                       // 所指 INode 的文件类型 f d，遍历目录时无需读取子 INode
     char filename[MAX_FILENAME_SIZE + 1]; // 最后一位必须保留为 '\0'
 
     Dentry()
-        : inode_id(-1)
+        : inode_id(-1), file_type('\0')
     {
         set_filename("unknown");
     }
 
-    Dentry(short inode_id, string filename)
-        : inode_id(inode_id)
+    Dentry(short inode_id, string filename, char file_type)
+        : inode_id(inode_id), file_type(file_type)
     {
         set_filename(filename);
     }
@@ -297,6 +839,7 @@ public:
     {
         os << "--------------- 目录项信息 ---------------" << endl;
         os << "INode ID：\t" << dentry.inode_id << endl;
+        os << "文件类型：\t" << dentry.file_type << endl;
         os << "文件名：\t" << dentry.filename << endl;
         os << "------------------------------------------" << endl;
         return os;
@@ -304,7 +847,7 @@ public:
 
     // 复制构造函数
     Dentry(const Dentry &dentry)
-        : inode_id(dentry.inode_id)
+        : inode_id(dentry.inode_id), file_type(dentry.file_type)
     {
         strcpy(this->filename, dentry.filename);
         // this->set_filename(dentry.get_filename());
@@ -314,12 +857,15 @@ public:
     Dentry &operator=(const Dentry &dentry)
     {
         this->inode_id = dentry.inode_id;
+        this->file_type = dentry.file_type;
         strcpy(this->filename, dentry.filename);
         // this->set_filename(dentry.get_filename());
         return *this;
     }
 };
 
+static_assert(sizeof(Dentry) == DENTRY_SIZE, "Dentry 必须恰好占用 DENTRY_SIZE 字节");
+
 class INode
 {
 public:
@@ -332,11 +878,26 @@ public:
     short direct_block[NUM_DIRECT_BLOCK];                   // 直接地址，占用 20 Byte
     short indirect_block[NUM_INDIRECT_BLOCK];               // 间接地址，占用 2 Byte
     short double_indirect_block[NUM_DOUBLE_INDIRECT_BLOCK]; // 双重间接地址，占用 2 Byte
-                                                            // 总共 41 Byte
+    int subtree_inode_cnt;                                  // 子树占用的 INode 数（含自身），占用 4 Byte
+    int subtree_block_cnt;                                  // 子树占用的块数（数据块 + 地址块），占用 4 Byte
+    int dentry_cnt;                                         // 目录中有效目录项数（含 . 与 ..），占用 4 Byte
+    short free_block_hint;                                  // 目录中第一个可能有空闲目录项的逻辑块号，之前的块均已满，占用 2 Byte
+    short tail_block;                                       // 尾部片段所在的打包块，-1 表示没有，占用 2 Byte
+    short tail_offset;                                      // 尾部片段在打包块内的字节偏移，占用 2 Byte
+    bool compressed;                                        // 数据块中的内容是否压缩存放（内联数据与尾部片段不压缩），占用 1 Byte
+    char inline_data[INLINE_DATA_SIZE];                     // 内联文件的内容（文件大小不超过 INLINE_DATA_SIZE 时使用），占用 64 Byte
+                                                            // 总共 124 Byte
     INode()
-        : id(-1), file_type('\0'), file_size(0), create_time(0), modify_time(0), link_cnt(0)
+        : id(-1), file_type('\0'), file_size(0), create_time(0), modify_time(0), link_cnt(0), subtree_inode_cnt(1), subtree_block_cnt(0), dentry_cnt(0), free_block_hint(0), tail_block(-1), tail_offset(0), compressed(false)
     {
         clear_address();
+        fill_n(inline_data, INLINE_DATA_SIZE, 0);
+    }
+
+    // 内联文件没有数据块，地址均为 -1，内容位于 inline_data（目录始终使用数据块）
+    bool is_inline() const
+    {
+        return file_type == 'f' && file_size <= INLINE_DATA_SIZE;
     }
 
     void clear_address()
@@ -362,6 +923,12 @@ public:
         os << "Create Time:\t\t" << Util::time_to_string(inode.create_time) << endl;
         os << "Modify Time:\t\t" << Util::time_to_string(inode.modify_time) << endl;
         os << "Link Count:\t\t" << inode.link_cnt << endl;
+        if (inode.is_inline())
+            os << "Inline Data:\t\t" << inode.file_size << " / " << INLINE_DATA_SIZE << " Byte" << endl;
+        if (inode.tail_block != -1)
+            os << "Packed Tail:\t\t" << Util::tail_size(inode.file_size) << " Byte in block " << inode.tail_block << " at offset " << inode.tail_offset << endl;
+        if (inode.compressed)
+            os << "Compressed:\t\t" << Util::data_block_num(inode.file_size) << " blocks stored in " << Util::data_block_num(inode.file_size, true) << endl;
 
         // os << "直接块：\t";
         os << "Direct Addr:\t\t";
@@ -381,11 +948,18 @@ public:
             os << inode.double_indirect_block[i] << " ";
         os << endl;
 
+        os << "Subtree INodes:\t\t" << inode.subtree_inode_cnt << endl;
+        os << "Subtree Blocks:\t\t" << inode.subtree_block_cnt << endl;
+        if (inode.file_type == 'd')
+            os << "Dentry Count:\t\t" << inode.dentry_cnt << endl;
+
         os << "--------------------------------------------------" << endl;
         return os;
     }
 };
 
+static_assert(sizeof(INode) <= INODE_SIZE, "INode 不能超过 INODE_SIZE 字节");
+
 class Bitmap
 {
 public:
@@ -427,1755 +1001,5747 @@ public:
     }
 };
 
-class FileSystem
+// 块 I/O 后端：批量读写时通过 io_uring 一次系统调用提交整批请求并等待全部完成，
+// 内核不支持 io_uring（或编译环境缺少头文件）时退化为逐个 preadv/pwritev
+class BlockIO
 {
-
 public:
-    // 持久化数据
-    SuperBlock superblock;
-    Bitmap block_bitmap = Bitmap(BLOCK_BITMAP_SIZE);
-    Bitmap inode_bitmap = Bitmap(INODE_BITMAP_SIZE);
+    // 一次传输：镜像中从 pos 开始的连续区间，对应的内存可以分散在多个缓冲区中
+    struct Request
+    {
+        int64_t pos;
+        vector<iovec> iov;
 
-    // 运行时数据
-    string working_dir;
-    short working_dir_inode_id;
+        explicit Request(int64_t pos)
+            : pos(pos) {}
 
-    const int SUPERBLOCK_CLASS_SIZE;
-    const int INODE_CLASS_SIZE;
+        Request(void *data, int64_t pos, int size)
+            : pos(pos), iov{{data, size_t(size)}} {}
 
-    FileSystem()
-        : SUPERBLOCK_CLASS_SIZE(sizeof(SuperBlock)), INODE_CLASS_SIZE(sizeof(INode))
-    {
-        if (!_is_filesys_exist())
-        {
-            // cout << "[文件系统初始化] 文件系统不存在，创建中 ..." << endl;
-            cout << "[Init] File system does not exist, creating ..." << endl;
-            _create_filesys();
-            // cout << "[文件系统初始化] 文件系统创建成功！" << endl;
-            cout << "[Init] File system created successfully!" << endl;
-        }
-        else
+        size_t size() const
         {
-            // cout << "[文件系统初始化] 文件系统已存在，加载中 ..." << endl;
-            cout << "[Init] File system already exists, loading ..." << endl;
-            _load(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
-            _load(block_bitmap.bitmap.data(), BLOCK_BITMAP_START, BLOCK_BITMAP_SIZE);
-            _load(inode_bitmap.bitmap.data(), INODE_BITMAP_START, INODE_BITMAP_SIZE);
-            // cout << "[文件系统初始化] 文件系统加载成功！" << endl;
-            cout << "[Init] File system loaded successfully!" << endl;
+            size_t size = 0;
+            for (const auto &vec : iov)
+                size += vec.iov_len;
+            return size;
         }
-        _init_working_dir();
-    }
+    };
+
+    int64_t read_request_num = 0;  // 批量读的传输次数（合并后）
+    int64_t write_request_num = 0; // 批量写的传输次数（合并后）
+    int64_t batch_num = 0;         // 经 io_uring 提交的批次数
+    int64_t request_num = 0;       // 经 io_uring 完成的请求数
+    int64_t enter_num = 0;         // io_uring_enter 系统调用次数
 
-    // 赋值构造函数
-    FileSystem(const FileSystem &fs)
-        : superblock(fs.superblock), block_bitmap(fs.block_bitmap), inode_bitmap(fs.inode_bitmap), working_dir(fs.working_dir), working_dir_inode_id(fs.working_dir_inode_id), SUPERBLOCK_CLASS_SIZE(fs.SUPERBLOCK_CLASS_SIZE), INODE_CLASS_SIZE(fs.INODE_CLASS_SIZE)
+    BlockIO()
     {
+        _setup_ring();
     }
 
-    // 重载赋值运算符
-    FileSystem &operator=(const FileSystem &fs)
+    ~BlockIO()
     {
-        superblock = fs.superblock;
-        block_bitmap = fs.block_bitmap;
-        inode_bitmap = fs.inode_bitmap;
-        working_dir = fs.working_dir;
-        working_dir_inode_id = fs.working_dir_inode_id;
-        return *this;
+        _teardown_ring();
     }
 
-    ~FileSystem()
+    BlockIO(const BlockIO &) = delete;
+    BlockIO &operator=(const BlockIO &) = delete;
+
+    bool is_async() const
     {
-        _dump_header();
-        // cout << "[文件系统退出] 文件系统元数据已保存，退出成功！" << endl;
-        cout << "[Exit] File system metadata saved, exit successfully!" << endl;
+        return ring_fd != -1;
     }
 
-    void _dump(const void *data, int pos, int size)
+    const char *name() const
     {
-        fstream file(FILESYSTEM_NAME, ios::in | ios::out | ios::binary);
-        if (!file)
-            // cout << "文件打开失败" << endl;
-            cout << "File open failed" << endl;
-        file.seekp(pos, ios::beg);
-        file.write((char *)data, size);
-        file.close();
+        return is_async() ? "io_uring" : "sync";
     }
 
-    // 将文件数据加载到内存（请特别小心 size 的设置，以免导致堆栈粉碎）
-    void _load(void *data, int pos, int size)
+    // 强制使用同步 I/O
+    void disable_async()
     {
-        fstream file(FILESYSTEM_NAME, ios::in | ios::out | ios::binary);
-        if (!file)
-            // cout << "文件打开失败" << endl;
-            cout << "File open failed" << endl;
-        file.seekg(pos, ios::beg);
-        file.read((char *)data, size);
-        file.close();
+        lock_guard<mutex> ring_lock(ring_mutex);
+        _teardown_ring();
     }
 
-    // 创建文件系统
-    void _create_filesys()
+    // 同步读取，读到文件末尾之后的部分视为全零
+    static bool read(int fd, void *data, int64_t pos, int size)
     {
-        fstream file(FILESYSTEM_NAME, ios::out | ios::binary | ios::trunc);
-        char *data = new char[FILESYSTEM_SIZE];
-        memset(data, 0, FILESYSTEM_SIZE);
-        file.write(data, FILESYSTEM_SIZE);
-        file.close();
-        delete[] data;
-
-        _dump_header();
-
-        _init_root_dir();
+        return transfer(fd, {{data, size_t(size)}}, pos, false);
     }
 
-    // 初始化根目录
-    void _init_root_dir()
+    static bool write(int fd, const void *data, int64_t pos, int size)
     {
-        dout << "[初始化根目录] 准备初始化 ..." << endl;
-
-        // Inode
-        _save_inode(_get_avail_inode(), 'd', BLOCK_SIZE);
-        // 数据块
-        _create_blank_dentries(_get_avail_block(), ROOT_INODE_ID, ROOT_INODE_ID);
-
-        dout << "[初始化根目录] 初始化完成！" << endl;
+        return transfer(fd, {{const_cast<void *>(data), size_t(size)}}, pos, true);
     }
 
-    void _init_working_dir()
+    // 同步地将 iov 描述的各缓冲区依次读写到镜像中从 pos 开始的连续区间，每次系统调用最多 IOV_MAX 个缓冲区
+    static bool transfer(int fd, vector<iovec> iov, int64_t pos, const bool is_write)
     {
-        working_dir = "/";
-        working_dir_inode_id = ROOT_INODE_ID;
-        dout << "[初始化工作目录] 当前工作目录为 " << working_dir << "（INode ID 为 " << working_dir_inode_id << "）" << endl;
+        size_t first = 0;
+        _advance(iov, first, 0);
+        while (first < iov.size())
+        {
+            const int num = min<size_t>(iov.size() - first, IOV_MAX);
+            const ssize_t ret = is_write ? ::pwritev(fd, &iov[first], num, pos) : ::preadv(fd, &iov[first], num, pos);
+            if (ret < 0 && errno == EINTR)
+                continue;
+            if (ret <= 0)
+            {
+                if (is_write)
+                {
+                    // cout << "文件写入失败" << endl;
+                    cout << "File write failed" << endl;
+                    return false;
+                }
+                for (; first < iov.size(); first++)
+                    memset(iov[first].iov_base, 0, iov[first].iov_len);
+                return ret == 0;
+            }
+            pos += ret;
+            _advance(iov, first, ret);
+        }
+        return true;
     }
 
-    bool _is_filesys_exist()
+    bool read_batch(int fd, const vector<Request> &requests)
     {
-        ifstream file(FILESYSTEM_NAME);
-        bool exist = file.good();
-        file.close();
-        return exist;
+        read_request_num += requests.size();
+        return _batch(fd, requests, false);
     }
 
-    void _load_header()
+    bool write_batch(int fd, const vector<Request> &requests)
     {
-        _load(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
-        _load(block_bitmap.bitmap.data(), BLOCK_BITMAP_START, BLOCK_BITMAP_SIZE);
-        _load(inode_bitmap.bitmap.data(), INODE_BITMAP_START, INODE_BITMAP_SIZE);
+        write_request_num += requests.size();
+        return _batch(fd, requests, true);
     }
 
-    void _dump_header()
+private:
+    int ring_fd = -1;
+    mutex ring_mutex;
+#ifdef HAS_IO_URING
+    void *sq_ring = MAP_FAILED;
+    void *cq_ring = MAP_FAILED;
+    size_t sq_ring_size = 0;
+    size_t cq_ring_size = 0;
+    io_uring_sqe *sqes = (io_uring_sqe *)MAP_FAILED;
+    size_t sqes_size = 0;
+    unsigned sq_entries = 0;
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+#endif
+
+    // 跳过 iov 中已传输的 bytes 字节，first 指向第一个仍有剩余的缓冲区
+    static void _advance(vector<iovec> &iov, size_t &first, size_t bytes)
     {
-        _dump(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
-        _dump(block_bitmap.bitmap.data(), BLOCK_BITMAP_START, BLOCK_BITMAP_SIZE);
-        _dump(inode_bitmap.bitmap.data(), INODE_BITMAP_START, INODE_BITMAP_SIZE);
+        for (; first < iov.size(); first++)
+        {
+            const size_t step = min(bytes, iov[first].iov_len);
+            iov[first].iov_base = (char *)iov[first].iov_base + step;
+            iov[first].iov_len -= step;
+            bytes -= step;
+            if (iov[first].iov_len > 0)
+                break;
+        }
     }
 
-    // 获取可用块 ID 并在 bitmap 中标记已使用
-    short _get_avail_block()
+    static bool _transfer_rest(int fd, const Request &request, size_t transferred, const bool is_write)
     {
-        for (int i = 0; i < superblock.block_num; i++)
-            if (!block_bitmap.get(i))
-            {
-                dout << "[可用块申请] 新申请：" << i << endl;
-                // Bitmap
-                block_bitmap.set(i);
-                _dump(block_bitmap.bitmap.data(), BLOCK_BITMAP_START, BLOCK_BITMAP_SIZE);
-                // Superblock
-                superblock.available_block_num--;
-                _dump(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
-                return i;
-            }
-
-        dout << "[可用块申请] 无可用块" << endl;
-        return -1;
+        vector<iovec> iov = request.iov;
+        size_t first = 0;
+        _advance(iov, first, transferred);
+        return transfer(fd, vector<iovec>(iov.begin() + first, iov.end()), request.pos + transferred, is_write);
     }
 
-    // 获取可用 inode ID 并在 bitmap 中标记已使用
-    short _get_avail_inode()
+    void _setup_ring()
     {
-        for (int i = 0; i < superblock.inode_num; i++)
-            if (!inode_bitmap.get(i))
+#ifdef HAS_IO_URING
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd = syscall(__NR_io_uring_setup, IO_QUEUE_DEPTH, &params);
+        if (ring_fd < 0)
+        {
+            ring_fd = -1;
+            dout << "[I/O] io_uring 不可用，使用同步 I/O" << endl;
+            return;
+        }
+        sq_entries = params.sq_entries;
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap)
+            sq_ring_size = cq_ring_size = max(sq_ring_size, cq_ring_size);
+
+        sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        cq_ring = single_mmap ? sq_ring : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = (io_uring_sqe *)mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED)
+        {
+            dout << "[I/O] io_uring 队列映射失败，使用同步 I/O" << endl;
+            _teardown_ring();
+            return;
+        }
+
+        sq_tail = (unsigned *)((char *)sq_ring + params.sq_off.tail);
+        sq_mask = (unsigned *)((char *)sq_ring + params.sq_off.ring_mask);
+        sq_array = (unsigned *)((char *)sq_ring + params.sq_off.array);
+        cq_head = (unsigned *)((char *)cq_ring + params.cq_off.head);
+        cq_tail = (unsigned *)((char *)cq_ring + params.cq_off.tail);
+        cq_mask = (unsigned *)((char *)cq_ring + params.cq_off.ring_mask);
+        cqes = (io_uring_cqe *)((char *)cq_ring + params.cq_off.cqes);
+        dout << "[I/O] 使用 io_uring，队列长度 " << sq_entries << endl;
+#endif
+    }
+
+    void _teardown_ring()
+    {
+#ifdef HAS_IO_URING
+        if (sqes != MAP_FAILED)
+            munmap(sqes, sqes_size);
+        if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+            munmap(cq_ring, cq_ring_size);
+        if (sq_ring != MAP_FAILED)
+            munmap(sq_ring, sq_ring_size);
+        sqes = (io_uring_sqe *)MAP_FAILED;
+        sq_ring = cq_ring = MAP_FAILED;
+#endif
+        if (ring_fd != -1)
+            close(ring_fd);
+        ring_fd = -1;
+    }
+
+    bool _batch(int fd, const vector<Request> &requests, const bool is_write)
+    {
+        unique_lock<mutex> ring_lock(ring_mutex);
+        // 单个请求走 io_uring 也需要一次系统调用，没有收益
+        if (ring_fd == -1 || requests.size() <= 1)
+        {
+            ring_lock.unlock();
+            bool ok = true;
+            for (const auto &request : requests)
+                ok &= transfer(fd, request.iov, request.pos, is_write);
+            return ok;
+        }
+
+        bool ok = true;
+#ifdef HAS_IO_URING
+        for (size_t first = 0; first < requests.size(); first += sq_entries)
+        {
+            const unsigned num = min<size_t>(sq_entries, requests.size() - first);
+            const unsigned tail = *sq_tail;
+            for (unsigned i = 0; i < num; i++)
             {
-                dout << "[可用 INode 申请] 新申请：" << i << endl;
-                // Bitmap
-                inode_bitmap.set(i);
-                _dump(inode_bitmap.bitmap.data(), INODE_BITMAP_START, INODE_BITMAP_SIZE);
-                // Superblock
-                superblock.available_inode_num--;
-                _dump(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
-                return i;
+                const Request &request = requests[first + i];
+                const unsigned index = (tail + i) & *sq_mask;
+                io_uring_sqe &sqe = sqes[index];
+                memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+                sqe.fd = fd;
+                sqe.off = request.pos;
+                sqe.addr = (uint64_t)request.iov.data();
+                sqe.len = request.iov.size();
+                sqe.user_data = first + i;
+                sq_array[index] = index;
             }
+            __atomic_store_n(sq_tail, tail + num, __ATOMIC_RELEASE);
+            batch_num++;
 
-        dout << "[可用 INode 申请] 无可用 INode" << endl;
-        return -1;
+            // 提交整批请求并等待全部完成，通常只需一次系统调用
+            unsigned to_submit = num, completed = 0;
+            vector<bool> done(num, false);
+            while (completed < num)
+            {
+                const int ret = syscall(__NR_io_uring_enter, ring_fd, to_submit, num - completed, IORING_ENTER_GETEVENTS, nullptr, 0);
+                enter_num++;
+                if (ret < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY))
+                    continue;
+                if (ret < 0)
+                {
+                    // 无法提交的请求改用同步 I/O 完成
+                    dout << "[I/O] io_uring_enter 失败：" << strerror(errno) << "，剩余请求改用同步 I/O" << endl;
+                    for (unsigned i = 0; i < num; i++)
+                        if (!done[i])
+                            ok &= transfer(fd, requests[first + i].iov, requests[first + i].pos, is_write);
+                    break;
+                }
+                to_submit -= ret;
+
+                unsigned head = *cq_head;
+                const unsigned cq_tail_now = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+                for (; head != cq_tail_now; head++)
+                {
+                    const io_uring_cqe &cqe = cqes[head & *cq_mask];
+                    const Request &request = requests[cqe.user_data];
+                    // 短读写或出错时用同步 I/O 补完剩余部分
+                    const size_t transferred = max(cqe.res, 0);
+                    if (transferred < request.size())
+                        ok &= _transfer_rest(fd, request, transferred, is_write);
+                    done[cqe.user_data - first] = true;
+                    completed++;
+                }
+                __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+            }
+            request_num += num;
+        }
+#endif
+        return ok;
     }
+};
 
-    void _clear_block(short id)
+// 日志头，位于日志区第一个块
+struct JournalHeader
+{
+    uint32_t magic = JOURNAL_MAGIC;
+    uint32_t sequence = 0; // 第一条有效记录的序号
+};
+
+// 日志记录的描述块：记录头之后紧跟各元数据块在镜像中的块号，描述块之后依次为各元数据块的内容
+struct JournalDescriptor
+{
+    uint32_t magic = JOURNAL_MAGIC;
+    uint32_t sequence = 0;
+    int32_t block_num = 0;
+    uint32_t reserved = 0;
+    uint64_t checksum = 0; // 覆盖块号与块内容，用于识别未完整写入的记录
+
+    // 记录 block_num 个块时描述块所占的块数
+    static int block_num_for(const int &block_num)
     {
-        // Bitmap
-        block_bitmap.set(id, 0);
-        _dump(block_bitmap.bitmap.data(), BLOCK_BITMAP_START, BLOCK_BITMAP_SIZE);
-        // Superblock
-        superblock.available_block_num++;
-        _dump(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
+        return (sizeof(JournalDescriptor) + block_num * sizeof(int32_t) + BLOCK_SIZE - 1) / BLOCK_SIZE;
     }
 
-    void _clear_block(vector<short> &block_id_list)
+    static uint64_t compute_checksum(const vector<int32_t> &block_no_list, const char *content)
     {
-        // Bitmap
-        for (const auto &block_id : block_id_list)
-            block_bitmap.set(block_id, 0);
-        _dump(block_bitmap.bitmap.data(), BLOCK_BITMAP_START, BLOCK_BITMAP_SIZE);
-        // Superblock
-        superblock.available_block_num += block_id_list.size();
-        _dump(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
+        uint64_t hash = Util::fnv1a(block_no_list.data(), block_no_list.size() * sizeof(int32_t));
+        return Util::fnv1a(content, block_no_list.size() * BLOCK_SIZE, hash);
     }
+};
 
-    void _clear_inode(short id)
+// 回写统计
+struct FlushStats
+{
+    int64_t wakeup_num = 0;       // 回写线程唤醒次数
+    int64_t commit_num = 0;       // 日志提交次数
+    int64_t checkpoint_num = 0;   // 检查点次数
+    int64_t journal_bytes = 0;    // 写入日志区的字节数
+    int64_t metadata_bytes = 0;   // 检查点写回元数据的字节数
+    int64_t data_bytes = 0;       // 写回文件数据的字节数
+    int64_t write_num = 0;        // 合并后实际发出的写请求数
+    int64_t punch_num = 0;        // 打洞请求数
+    int64_t punched_bytes = 0;    // 打洞丢弃的字节数
+};
+
+// 预读统计
+struct ReadAheadStats
+{
+    int64_t window_num = 0;   // 读取的窗口数
+    int64_t prefetch_num = 0; // 在后台发起的预读窗口数
+    int64_t hit_num = 0;      // 访问时已由预读取得的窗口数
+    int64_t block_num = 0;    // 经预读器读取的数据块数
+};
+
+// 块校验统计
+struct ChecksumStats
+{
+    int64_t verified_num = 0; // 读取时校验的块数
+    int64_t error_num = 0;    // 校验不符的块数
+};
+
+// 一致性检查时单个 INode 的扫描结果，由各工作线程分别填写
+struct FsckScan
+{
+    bool valid = false;         // INode 表中该位置是否为有效的文件或目录
+    INode inode;                // INode 表中的内容
+    vector<short> block_list;   // 引用的数据块、地址块与尾部打包块
+    vector<short> invalid_list; // 超出数据区范围的块地址
+    vector<Dentry> dentry_list; // 目录的有效目录项
+};
+
+// 尾部打包块的占用情况，加载时由 INode 表重建，不写入磁盘
+struct TailBlock
+{
+    uint32_t slot_mask = 0; // 已占用的槽位
+    int tail_num = 0;       // 存放的尾部片段数
+    int byte_num = 0;       // 尾部片段的总字节数
+};
+
+// 分配组的运行时统计，加载时由 bitmap 与 INode 表计算得到，不写入磁盘
+// 组内 bitmap 与计数的修改由本组的锁保护；计数为原子变量，无需加锁即可汇总
+struct AllocGroup
+{
+    atomic<int> free_block_num{0};
+    atomic<int> free_inode_num{0};
+    atomic<int> dir_num{0};
+    mutex lock;
+
+    AllocGroup()
     {
-        // Bitmap
-        inode_bitmap.set(id, 0);
-        _dump(inode_bitmap.bitmap.data(), INODE_BITMAP_START, INODE_BITMAP_SIZE);
-        // Superblock
-        superblock.available_inode_num++;
-        _dump(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
     }
 
-    // 目录 d 的数据块
-    void _create_blank_dentries(const short &block_id, const short &curr_dir_inode_id, const short &parent_dir_inode_id)
+    // 复制构造函数（锁不复制）
+    AllocGroup(const AllocGroup &group)
+        : free_block_num(group.free_block_num.load()), free_inode_num(group.free_inode_num.load()), dir_num(group.dir_num.load())
     {
-        // dout << "[创建空 Dentry 数据块] Block ID: " << block_id << "，当前目录 INode ID: " << curr_dir_inode_id << "，父目录 INode ID: " << parent_dir_inode_id << endl;
+    }
 
-        vector<Dentry> dentry(DENTRY_NUM_PER_BLOCK);
+    // 赋值运算符重载
+    AllocGroup &operator=(const AllocGroup &group)
+    {
+        free_block_num = group.free_block_num.load();
+        free_inode_num = group.free_inode_num.load();
+        dir_num = group.dir_num.load();
+        return *this;
+    }
+};
 
-        dentry[0] = Dentry(curr_dir_inode_id, ".");
-        INode curr_dir_inode = _get_inode(curr_dir_inode_id);
-        curr_dir_inode.direct_block[0] = block_id;
-        curr_dir_inode.link_cnt++;
-        _save_inode(curr_dir_inode);
-        // dout << "[创建空 Dentry 数据块] Curr Dir INode ID：" << curr_dir_inode_id << endl
-        //      << curr_dir_inode << endl;
-        // dout << "[创建空 Dentry 数据块] INode 0：" << endl
-        //      << _get_inode(0) << endl;
+// 目录项名称的 Bloom 过滤器，只会误报存在，不会漏报
+class BloomFilter
+{
+public:
+    vector<uint64_t> bits;
+    int capacity; // 设计容量，目录项超过该数量后误报率上升，需要重建
 
-        dentry[1] = Dentry(parent_dir_inode_id, "..");
-        INode parent_dir_inode = _get_inode(parent_dir_inode_id);
-        parent_dir_inode.link_cnt++;
-        _save_inode(parent_dir_inode);
-        // dout << "[创建空 Dentry 数据块] Parent Dir INode ID：" << parent_dir_inode_id << endl
-        //      << parent_dir_inode << endl;
-        // dout << "[创建空 Dentry 数据块] INode 0：" << endl
-        //      << _get_inode(0) << endl;
+    BloomFilter(int capacity = 0)
+        : capacity(capacity)
+    {
+        bits.resize(max(1, (capacity * BLOOM_BITS_PER_ENTRY + 63) / 64), 0);
+    }
 
-        _dump(dentry.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+    void insert(const string &key)
+    {
+        uint64_t h1, h2;
+        _hash(key, h1, h2);
+        const uint64_t bit_num = bits.size() * 64;
+        for (int i = 0; i < BLOOM_HASH_NUM; i++)
+        {
+            const uint64_t pos = (h1 + i * h2) % bit_num;
+            bits[pos / 64] |= 1ULL << (pos % 64);
+        }
     }
 
-    void _create_blank_dentries(const short &block_id)
+    bool may_contain(const string &key) const
     {
-        vector<Dentry> dentry(DENTRY_NUM_PER_BLOCK);
-        _dump(dentry.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+        uint64_t h1, h2;
+        _hash(key, h1, h2);
+        const uint64_t bit_num = bits.size() * 64;
+        for (int i = 0; i < BLOOM_HASH_NUM; i++)
+        {
+            const uint64_t pos = (h1 + i * h2) % bit_num;
+            if (!(bits[pos / 64] & (1ULL << (pos % 64))))
+                return false;
+        }
+        return true;
     }
 
-    // inode 的间接地址数据块
-    void _create_blank_address_block(short block_id)
+private:
+    // FNV-1a 哈希经 splitmix64 混合后得到两个基础哈希，再用双重哈希生成各个位置
+    static void _hash(const string &key, uint64_t &h1, uint64_t &h2)
     {
-        short *block = new short[ADDRESS_PER_BLOCK];
-        fill_n(block, ADDRESS_PER_BLOCK, -1);
-        _dump(block, BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
-        delete[] block;
+        uint64_t h = 14695981039346656037ULL;
+        for (const unsigned char c : key)
+        {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        h1 = _mix(h);
+        h2 = _mix(h1) | 1;
     }
 
-    // 由块ID向量生成直接块ID、间接块ID、双重间接块ID
-    // 确保文件大小不超过最大值才执行以下函数
-    void _set_block_list(INode &inode, const vector<short> &block_id_list)
+    static uint64_t _mix(uint64_t x)
     {
-        // 清空 INode 地址
-        inode.clear_address();
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+};
 
-        // 将 block_id_list 分成直接块、间接块、双重间接块三个部分
-        vector<short> _direct_block_list;
-        vector<short> _indirect_block_list;
-        vector<short> _double_indirect_block_list;
+class FileSystem
+{
 
-        dout << "[写入 INode 块地址] 共有 " << block_id_list.size() << " 个数据块" << endl;
-        for (int i = 0; i < block_id_list.size(); i++)
+public:
+    // 持久化数据
+    SuperBlock superblock;
+    Bitmap block_bitmap = Bitmap(BLOCK_BITMAP_SIZE);
+    Bitmap inode_bitmap = Bitmap(INODE_BITMAP_SIZE);
+
+    // 运行时数据
+    string working_dir;
+    short working_dir_inode_id;
+    unordered_map<short, BloomFilter> dentry_filters; // 大目录的目录项过滤器（按目录 INode ID），首次查找时由磁盘内容构建
+    vector<AllocGroup> alloc_groups = vector<AllocGroup>(GROUP_NUM);
+    map<short, TailBlock> tail_blocks;                // 尾部打包块（按块 ID）
+    unordered_map<short, int> block_refs;             // 被多个逻辑块共享的数据块的引用数（均不小于 2），去重后产生
+    unordered_map<short, vector<short>> link_dirs;    // 各文件的目录项所在的目录（按文件 INode ID，同一目录中有多个硬链接时重复出现）
+    bool link_dirs_ready = false;                     // link_dirs 首次调整多链接文件的大小时由目录树构建，之后随目录项的增删维护
+    bool compress_new_files = false;                  // 新建的文件是否压缩存放（启动参数，erase 时保留）
+
+    // 元数据日志（按镜像内 BLOCK_SIZE 大小的块管理，块号 = 偏移 / BLOCK_SIZE）
+    int fd = -1;                                      // 镜像文件描述符，整个生命周期内保持打开
+    BlockIO io;                                       // 块 I/O 后端，与镜像文件无关，erase 时保留
+    unordered_map<int, vector<char>> dirty_blocks;    // 尚未写回原位置的元数据块的最新内容，读取时覆盖磁盘内容
+    map<int, vector<char>> committed_blocks;          // 已写入日志但尚未写回原位置的块（提交时的内容），检查点时写回
+    set<int> uncommitted_blocks;                      // 上次提交以来修改过的块
+    set<short> freed_blocks;                          // 上次提交以来释放的数据块，提交后对其所在的主机页打洞
+    set<short> allocated_blocks;                      // 上次提交以来分配的数据块，其数据不经日志直接写回
+    int transaction_depth = 0;                        // 嵌套的事务作用域层数
+    int pending_transaction_num = 0;                  // 已关闭但尚未提交的事务数
+    uint32_t journal_sequence = 0;                    // 下一条日志记录的序号
+    int journal_used_block_num = 0;                   // 日志区已使用的块数（不含日志头）
+    mutex journal_mutex;
+
+    // 后台回写（以下状态均由 journal_mutex 保护）
+    map<int, vector<char>> dirty_data_blocks; // 尚未写回的文件数据块，提交日志前按块号顺序合并写回
+    thread flusher;
+    condition_variable flusher_cv;
+    bool flusher_stop = false;
+    bool flush_requested = false;
+    int flush_interval_ms = FLUSH_INTERVAL_MS;
+    int flush_dirty_threshold = FLUSH_DIRTY_THRESHOLD;
+    FlushStats flush_stats;
+    ReadAheadStats readahead_stats;
+
+    // 块校验和（由 journal_mutex 保护）：与各块最近一次提交的内容对应，校验和区的块随日志记录提交、检查点时写回
+    vector<uint32_t> block_checksums; // 按镜像块号索引
+    set<int> dirty_checksum_blocks;   // 有校验和被修改、尚未随日志提交的块（校验和区内的序号）
+    vector<char> verified_blocks;     // 原位置上的内容已校验过的块，部分读取时据此只校验一次，块写回原位置后清除
+    ChecksumStats checksum_stats;
+
+    const int SUPERBLOCK_CLASS_SIZE;
+    const int INODE_CLASS_SIZE;
+
+    FileSystem()
+        : SUPERBLOCK_CLASS_SIZE(sizeof(SuperBlock)), INODE_CLASS_SIZE(sizeof(INode))
+    {
+        if (!_is_filesys_exist())
         {
-            if (i < NUM_DIRECT_BLOCK)
-                _direct_block_list.push_back(block_id_list[i]);
-            else if (i < NUM_DIRECT_BLOCK + NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK)
-                _indirect_block_list.push_back(block_id_list[i]);
-            else if (i < NUM_DIRECT_BLOCK + NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK + NUM_DOUBLE_INDIRECT_BLOCK * ADDRESS_PER_BLOCK * ADDRESS_PER_BLOCK)
-                _double_indirect_block_list.push_back(block_id_list[i]);
+            // cout << "[文件系统初始化] 文件系统不存在，创建中 ..." << endl;
+            cout << "[Init] File system does not exist, creating ..." << endl;
+            if (!_create_filesys())
+                return;
+            // cout << "[文件系统初始化] 文件系统创建成功！" << endl;
+            cout << "[Init] File system created successfully!" << endl;
         }
-
-        // 直接块
-        if (!_direct_block_list.empty())
-            for (int i = 0; i < _direct_block_list.size(); i++)
+        else
+        {
+            // cout << "[文件系统初始化] 文件系统已存在，加载中 ..." << endl;
+            cout << "[Init] File system already exists, loading ..." << endl;
+            fd = open(image_path.c_str(), O_RDWR);
+            // 超级块的位置与几何参数无关，先读出几何参数，再据此定位其余区域
+            _pread(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
+            const Geometry image_geometry = superblock.to_geometry();
+            const string geometry_error = image_geometry.validate();
+
+            // 磁盘格式与当前版本不兼容或几何参数无效时拒绝挂载，绝不自动重新格式化，由用户决定是否用 mkfs 或 erase 覆盖
+            string refuse_reason;
+            if (superblock.version != FILESYSTEM_VERSION)
+                refuse_reason = "format version " + to_string(superblock.version) + " is incompatible with version " + to_string(FILESYSTEM_VERSION);
+            else if (!geometry_error.empty())
+                refuse_reason = "geometry is invalid (" + geometry_error + ")";
+            if (!refuse_reason.empty())
             {
-                inode.direct_block[i] = _direct_block_list[i];
-                dout << "[写入 INode 块地址] 直接块 " << i << "：" << inode.direct_block[i] << endl;
+                cout << "[Init] File system " << refuse_reason << ", refusing to mount" << endl;
+                cout << "[Init] Run 'mkfs' or 'erase' to format " << image_path << " (its contents will be lost)" << endl;
+                _close_image();
+                return;
             }
 
-        // 间接块
-        if (!_indirect_block_list.empty())
-        {
-            inode.indirect_block[0] = _get_avail_block();
+            geometry = image_geometry;
+            block_bitmap = Bitmap(BLOCK_BITMAP_SIZE);
+            inode_bitmap = Bitmap(INODE_BITMAP_SIZE);
 
-            short *block = new short[ADDRESS_PER_BLOCK];
-            fill_n(block, ADDRESS_PER_BLOCK, -1);
+            // 先重放日志，再读取元数据
+            _load_checksums();
+            const int replayed_num = _journal_recover();
+            if (replayed_num > 0)
+                cout << "[Init] Replayed " << replayed_num << " committed journal transactions" << endl;
+            _load_header();
+            _init_alloc_groups();
 
-            for (int j = 0; j < _indirect_block_list.size(); j++)
+            // 上次未正常卸载，检查并修复元数据
+            if (superblock.mount_state != 0)
             {
-                dout << "[写入 INode 块地址] 间接块 " << j << "：" << _indirect_block_list[j] << endl;
-                block[j] = _indirect_block_list[j];
+                cout << "[Init] File system was not cleanly unmounted, checking ..." << endl;
+                fsck(true);
             }
 
-            _dump(block, BLOCK_START + inode.indirect_block[0] * BLOCK_SIZE, BLOCK_SIZE);
-            delete[] block;
+            // cout << "[文件系统初始化] 文件系统加载成功！" << endl;
+            cout << "[Init] File system loaded successfully!" << endl;
         }
+        _set_mount_state(1);
+        _init_working_dir();
+    }
 
-        // 二级间接块
-        if (!_double_indirect_block_list.empty())
+    ~FileSystem()
+    {
+        _stop_flusher();
+        // 镜像未能打开或拒绝挂载，没有需要保存的内容
+        if (fd == -1)
+            return;
+        // 操作进行到一半时退出（如命令执行中途调用 exit）不算正常卸载，保留挂载标记，下次启动时检查
+        if (transaction_depth == 0)
+            superblock.mount_state = 0;
+        _dump_header();
+        _journal_flush();
+        _close_image();
+        // cout << "[文件系统退出] 文件系统元数据已保存，退出成功！" << endl;
+        cout << "[Exit] File system metadata saved, exit successfully!" << endl;
+    }
+
+    // 事务作用域：一次公开操作的全部元数据修改组成一个事务，最外层作用域结束时事务关闭
+    struct TransactionScope
+    {
+        FileSystem &fs;
+
+        explicit TransactionScope(FileSystem &fs)
+            : fs(fs)
+        {
+            lock_guard<mutex> journal_lock(fs.journal_mutex);
+            fs.transaction_depth++;
+        }
+
+        ~TransactionScope()
+        {
+            fs._end_transaction();
+        }
+    };
+
+    // 顺序读取文件内容的预读器：按窗口批量读取数据块，访问保持顺序时窗口逐次翻倍，
+    // 并在调用方处理当前窗口的同时于后台读取下一个窗口（含其所需的间接地址块）；随机访问时窗口退回初始大小且不预读
+    class FileReader
+    {
+    public:
+        FileReader(FileSystem &fs, const INode &inode)
+            : fs(fs), inode(inode), block_num(Util::data_block_num(inode.file_size)) {}
+
+        ~FileReader()
         {
-            dout << "[写入 INode 块地址] 二级地址需管理共 " << _double_indirect_block_list.size() << " 个数据块" << endl;
-            dout << "[写入 INode 块地址] 二级地址第一级共 " << ceil(float(_double_indirect_block_list.size()) / ADDRESS_PER_BLOCK) << " 个地址" << endl;
+            if (prefetch.valid())
+                prefetch.wait();
+        }
 
-            inode.double_indirect_block[0] = _get_avail_block();
-            short _1st_address_block[ADDRESS_PER_BLOCK]; // 二级地址块的地址
-            fill_n(_1st_address_block, ADDRESS_PER_BLOCK, -1);
+        int get_block_num() const
+        {
+            return block_num;
+        }
 
-            for (int i = 0; i < ceil(float(_double_indirect_block_list.size()) / ADDRESS_PER_BLOCK); i++)
+        // 返回逻辑块 idx 的内容，在下一次调用前有效
+        const char *block(const int &idx)
+        {
+            const bool sequential = idx == last_idx + 1;
+            last_idx = idx;
+            if (!_in_window(current, idx))
             {
-                _1st_address_block[i] = _get_avail_block();
-                dout << "[写入 INode 块地址] 二级间接块 " << i << "：" << _1st_address_block[i] << endl;
+                // 同一时刻至多一个窗口在读取，地址块缓存因此无需加锁
+                if (prefetch.valid())
+                {
+                    Window next = prefetch.get();
+                    if (_in_window(next, idx))
+                    {
+                        current = std::move(next);
+                        fs.readahead_stats.hit_num++;
+                    }
+                }
+                if (!_in_window(current, idx))
+                {
+                    if (!sequential)
+                        window_len = READAHEAD_MIN_BLOCK_NUM;
+                    current = _read_window(idx, window_len);
+                }
 
-                short *block = new short[ADDRESS_PER_BLOCK];
-                fill_n(block, ADDRESS_PER_BLOCK, -1);
-                for (int j = 0; j < ADDRESS_PER_BLOCK; j++)
+                // 顺序访问时扩大窗口，并立即在后台读取紧随其后的窗口
+                if (sequential)
                 {
-                    if (i * ADDRESS_PER_BLOCK + j >= _double_indirect_block_list.size())
-                        break;
-                    block[j] = _double_indirect_block_list[i * ADDRESS_PER_BLOCK + j];
-                    dout << "[写入 INode 块地址] 二级间接块（第二级） " << i << "，地址 " << j << "：" << block[j] << endl;
+                    window_len = min(window_len * 2, READAHEAD_MAX_BLOCK_NUM);
+                    const int next_first = current.first + current.len;
+                    if (next_first < block_num)
+                    {
+                        prefetch = async(launch::async, &FileReader::_read_window, this, next_first, window_len);
+                        fs.readahead_stats.prefetch_num++;
+                    }
                 }
-                _dump(block, BLOCK_START + _1st_address_block[i] * BLOCK_SIZE, BLOCK_SIZE);
-                delete[] block;
             }
-            _dump(_1st_address_block, BLOCK_START + inode.double_indirect_block[0] * BLOCK_SIZE, BLOCK_SIZE);
+            return current.content.data() + (idx - current.first) * BLOCK_SIZE;
         }
 
-        _save_inode(inode);
-    }
-
-    void _set_block_list(const short &inode_id, const vector<short> &block_id_list)
-    {
-        INode inode = _get_inode(inode_id);
-        assert(inode.id == inode_id);
-        _set_block_list(inode, block_id_list);
-    }
-
-    // 由 inode 的直接块ID、间接块ID、双重间接块ID获取其块ID向量
-    // 返回块 ID 向量，根据这个向量就能获取所有内容
-    vector<short> _get_block_list(const INode &inode)
-    {
-        vector<short> block_id_list;
+    private:
+        struct Window
+        {
+            int first = 0;
+            int len = 0;
+            vector<char> content;
+        };
+
+        FileSystem &fs;
+        const INode inode;
+        const int block_num;
+        int last_idx = -1;
+        int window_len = READAHEAD_MIN_BLOCK_NUM;
+        Window current;
+        future<Window> prefetch;
+        unordered_map<short, vector<short>> address_blocks; // 本次读取中已加载的间接地址块
+
+        static bool _in_window(const Window &window, const int &idx)
+        {
+            return idx >= window.first && idx < window.first + window.len;
+        }
 
-        // 直接块
-        for (int i = 0; i < NUM_DIRECT_BLOCK; i++)
-            if (inode.direct_block[i] != -1)
+        Window _read_window(const int first, const int len)
+        {
+            Window window;
+            window.first = first;
+            window.len = min(len, block_num - first);
+            int read_block_num = window.len;
+            if (inode.compressed)
             {
-                // dout << "[读取 INode 块列表] 直接块 " << i << " ：" << inode.direct_block[i] << endl;
-                block_id_list.push_back(inode.direct_block[i]);
+                // 压缩文件：窗口对应压缩流中连续的若干组，其所在的数据块读入窗口末尾的余量后原地解压
+                const int content_size = inode.file_size - Util::rest_size(inode.file_size);
+                const int group_begin = first * BLOCK_SIZE / PACK_GROUP_SIZE;
+                const int group_end = (min((first + window.len) * BLOCK_SIZE, content_size) + PACK_GROUP_SIZE - 1) / PACK_GROUP_SIZE;
+                window.content.resize(max(window.len * BLOCK_SIZE, _unpack_buffer_size(group_end - group_begin)));
+                read_block_num = fs._unpack_groups([this](const int &idx)
+                                                   { return _get_block_id(idx); }, group_begin, group_end, window.content.data());
             }
-
-        // 间接块
-        for (int i = 0; i < NUM_INDIRECT_BLOCK; i++)
-            if (inode.indirect_block[i] != -1)
+            else
             {
-                // dout << "[读取 INode 块列表] 间接块 " << i << " ：" << inode.indirect_block[i] << endl;
-                vector<short> block(ADDRESS_PER_BLOCK, -1);
-                _load(block.data(), BLOCK_START + inode.indirect_block[i] * BLOCK_SIZE, BLOCK_SIZE);
-                for (int j = 0; j < ADDRESS_PER_BLOCK; j++)
-                    if (block[j] != -1)
-                    {
-                        // dout << "[读取 INode 块列表] 间接块 " << i << " ，地址 " << j << " ：" << block[j] << endl;
-                        block_id_list.push_back(block[j]);
-                    }
+                window.content.resize(window.len * BLOCK_SIZE);
+                vector<short> block_id_list(window.len);
+                for (int i = 0; i < window.len; i++)
+                    block_id_list[i] = _get_block_id(first + i);
+                fs._load_blocks(block_id_list, window.content.data());
             }
+            fs.readahead_stats.window_num++;
+            fs.readahead_stats.block_num += read_block_num;
+            return window;
+        }
 
-        // 二级间接块
-        for (int i = 0; i < NUM_DOUBLE_INDIRECT_BLOCK; i++)
-            if (inode.double_indirect_block[i] != -1)
+        // 与 FileSystem::_get_block_id 相同的寻址，但整块加载并缓存间接地址块
+        short _get_block_id(int idx)
+        {
+            if (idx < NUM_DIRECT_BLOCK)
+                return inode.direct_block[idx];
+            idx -= NUM_DIRECT_BLOCK;
+            if (idx < NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK)
+                return _address(inode.indirect_block[0], idx);
+            idx -= NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK;
+            return _address(_address(inode.double_indirect_block[0], idx / ADDRESS_PER_BLOCK), idx % ADDRESS_PER_BLOCK);
+        }
+
+        short _address(const short &address_block_id, const int &idx)
+        {
+            if (address_block_id == -1)
+                return -1;
+            auto it = address_blocks.find(address_block_id);
+            if (it == address_blocks.end())
             {
-                // dout << "[读取 INode 块列表] 双重间接块 " << i << " ：" << inode.double_indirect_block[i] << endl;
-                vector<short> block(ADDRESS_PER_BLOCK, -1);
-                _load(block.data(), BLOCK_START + inode.double_indirect_block[i] * BLOCK_SIZE, BLOCK_SIZE);
-                for (int j = 0; j < ADDRESS_PER_BLOCK; j++)
-                    if (block[j] != -1)
-                    {
-                        // dout << "[读取 INode 块列表] 双重间接块 " << i << " ，地址 " << j << " ：" << block[j] << endl;
-                        vector<short> block2(ADDRESS_PER_BLOCK, -1);
-                        _load(block2.data(), BLOCK_START + block[j] * BLOCK_SIZE, BLOCK_SIZE);
-                        for (int k = 0; k < ADDRESS_PER_BLOCK; k++)
-                            if (block2[k] != -1)
-                                block_id_list.push_back(block2[k]);
-                    }
+                it = address_blocks.emplace(address_block_id, vector<short>(ADDRESS_PER_BLOCK, -1)).first;
+                fs._load(it->second.data(), BLOCK_START + address_block_id * BLOCK_SIZE, BLOCK_SIZE);
             }
+            return it->second[idx];
+        }
+    };
 
-        return block_id_list;
+    // 按字节读写镜像文件，不经过日志
+    void _pread(void *data, int pos, int size)
+    {
+        BlockIO::read(fd, data, pos, size);
     }
 
-    vector<short> _get_block_list(const short &inode_id)
+    void _pwrite(const void *data, int pos, int size)
     {
-        INode inode = _get_inode(inode_id);
-        return _get_block_list(inode);
+        BlockIO::write(fd, data, pos, size);
     }
 
-    // 只存放间接地址块，有别于数据块
-    vector<short> _get_addr_block_list(const INode &inode)
+    // 写入元数据：修改只进入内存中的脏块，随事务提交写入日志，检查点时才写回原位置
+    void _dump(const void *data, int pos, int size)
     {
-        vector<short> indirect_block_list;
+        lock_guard<mutex> journal_lock(journal_mutex);
+        for (int block_no = pos / BLOCK_SIZE; block_no * BLOCK_SIZE < pos + size; block_no++)
+            _dump_journaled(block_no, data, pos, size);
+    }
 
-        // 间接块
-        for (int i = 0; i < NUM_INDIRECT_BLOCK; i++)
-            if (inode.indirect_block[i] != -1)
-                indirect_block_list.push_back(inode.indirect_block[i]);
+    // 将 [pos, pos + size) 中落在 block_no 内的部分写入该块的日志内容（调用前需持有 journal_mutex）
+    void _dump_journaled(const int &block_no, const void *data, int pos, int size)
+    {
+        auto it = dirty_blocks.find(block_no);
+        if (it == dirty_blocks.end())
+        {
+            it = dirty_blocks.emplace(block_no, vector<char>(BLOCK_SIZE)).first;
+            _pread(it->second.data(), block_no * BLOCK_SIZE, BLOCK_SIZE);
+        }
+        // 数据块被释放后复用为元数据块，未写回的旧数据作废
+        dirty_data_blocks.erase(block_no);
+        const int begin = max(pos, block_no * BLOCK_SIZE);
+        const int end = min(pos + size, (block_no + 1) * BLOCK_SIZE);
+        memcpy(it->second.data() + begin - block_no * BLOCK_SIZE, (const char *)data + begin - pos, end - begin);
+        uncommitted_blocks.insert(block_no);
+    }
 
-        // 二级间接块
-        for (int i = 0; i < NUM_DOUBLE_INDIRECT_BLOCK; i++)
-            if (inode.double_indirect_block[i] != -1)
+    // 写入文件数据：上次提交以来新分配的块不经过日志，先放入脏数据块，在下一次提交日志前写回原位置，
+    // 崩溃时这些块在恢复后的 bitmap 中仍为空闲，内容与校验和无关紧要；
+    // 已提交的块原地改写时与元数据一样经过日志，使其内容与随日志提交的校验和一同生效
+    void _dump_data(const void *data, int pos, int size)
+    {
+        lock_guard<mutex> journal_lock(journal_mutex);
+        for (int block_no = pos / BLOCK_SIZE; block_no * BLOCK_SIZE < pos + size; block_no++)
+        {
+            if (!allocated_blocks.count(block_no - BLOCK_START / BLOCK_SIZE))
             {
-                // 将二级中的第一级间接块加入列表
-                indirect_block_list.push_back(inode.double_indirect_block[i]);
-
-                // 读取二级间接块
-                vector<short> addresses(ADDRESS_PER_BLOCK, -1);
-                _load(addresses.data(), BLOCK_START + inode.double_indirect_block[i] * BLOCK_SIZE, BLOCK_SIZE);
-                dout << "[获取间接地址块列表] 二级间接块第一级所有地址：" << addresses << endl;
-                for (const auto &address : addresses)
-                    if (address != -1)
-                        // 将二级中的第二级数据块加入列表
-                        indirect_block_list.push_back(address);
+                _dump_journaled(block_no, data, pos, size);
+                continue;
             }
 
-        dout << "[获取间接地址块列表] 间接地址块列表大小：" << indirect_block_list.size() << endl;
-        dout << "[获取间接地址块列表] 间接地址块列表：" << indirect_block_list << endl;
+            // 由元数据复用为数据块：旧的元数据内容已失效，不再覆盖读取，也不再随日志提交；
+            // 日志中已提交的旧内容由提交时先做检查点处理（见 _journal_commit），不能在事务中途提交
+            if (dirty_blocks.count(block_no) && !dirty_data_blocks.count(block_no))
+            {
+                dout << "[日志] 块 " << block_no << " 由元数据复用为数据块，丢弃其未写回的元数据内容" << endl;
+                dirty_blocks.erase(block_no);
+                uncommitted_blocks.erase(block_no);
+            }
 
-        return indirect_block_list;
+            auto it = dirty_data_blocks.find(block_no);
+            const int begin = max(pos, block_no * BLOCK_SIZE);
+            const int end = min(pos + size, (block_no + 1) * BLOCK_SIZE);
+            if (it == dirty_data_blocks.end())
+            {
+                it = dirty_data_blocks.emplace(block_no, vector<char>(BLOCK_SIZE)).first;
+                if (end - begin < BLOCK_SIZE)
+                    _pread(it->second.data(), block_no * BLOCK_SIZE, BLOCK_SIZE);
+            }
+            memcpy(it->second.data() + begin - block_no * BLOCK_SIZE, (const char *)data + begin - pos, end - begin);
+        }
     }
 
-    vector<short> _get_addr_block_list(const short &inode_id)
+    // 将文件数据加载到内存（请特别小心 size 的设置，以免导致堆栈粉碎）
+    // 先读取磁盘内容并校验，再用尚未写回的脏块覆盖；只读取了一部分的块（如单个 INode）另行读出整块校验，每块只校验一次
+    void _load(void *data, int pos, int size)
     {
-        INode inode = _get_inode(inode_id);
-        return _get_addr_block_list(inode);
+        lock_guard<mutex> journal_lock(journal_mutex);
+        _pread(data, pos, size);
+        for (int block_no = pos / BLOCK_SIZE; block_no * BLOCK_SIZE < pos + size; block_no++)
+        {
+            if (block_no * BLOCK_SIZE >= pos && (block_no + 1) * BLOCK_SIZE <= pos + size)
+                _verify_block(block_no, (const char *)data + block_no * BLOCK_SIZE - pos);
+            else if (_has_checksum(block_no) && !verified_blocks.empty() && !verified_blocks[block_no] && !_is_dirty(block_no))
+            {
+                vector<char> block(BLOCK_SIZE);
+                _pread(block.data(), block_no * BLOCK_SIZE, BLOCK_SIZE);
+                _verify_block(block_no, block.data());
+            }
+        }
+        _overlay_dirty(data, pos, size);
     }
 
-    string _absolute_path(const string path)
+    // 块是否有尚未写回原位置的内容（调用前需持有 journal_mutex）
+    bool _is_dirty(const int &block_no) const
     {
-        dout << "[获取绝对路径] 原始路径：" << path << endl;
+        return dirty_blocks.count(block_no) || dirty_data_blocks.count(block_no);
+    }
 
-        if (path.empty())
+    // 批量加载数据块，各块依次放入 buffer：物理上连续的块合并为一次读取，各段一并交给 I/O 后端，再用脏块覆盖
+    void _load_blocks(const vector<short> &block_id_list, char *buffer)
+    {
+        lock_guard<mutex> journal_lock(journal_mutex);
+        const int block_num = block_id_list.size();
+        vector<BlockIO::Request> requests;
+        for (int i = 0, run_len; i < block_num; i += run_len)
         {
-            dout << "[获取绝对路径] 路径为当前工作目录：" << working_dir << endl;
-            return working_dir;
+            for (run_len = 1; i + run_len < block_num && block_id_list[i + run_len] == block_id_list[i] + run_len; run_len++)
+                ;
+            requests.emplace_back(buffer + i * BLOCK_SIZE, BLOCK_START + block_id_list[i] * BLOCK_SIZE, run_len * BLOCK_SIZE);
         }
-
-        // 如果是绝对路径，直接返回
-        if (path[0] == '/')
+        dout << "[加载数据块] " << block_num << " 个数据块合并为 " << requests.size() << " 段读取" << endl;
+        io.read_batch(fd, requests);
+        for (int i = 0; i < block_num; i++)
         {
-            dout << "[获取绝对路径] " << path << " 为绝对路径" << endl;
-            return path;
+            _verify_block(BLOCK_START / BLOCK_SIZE + block_id_list[i], buffer + i * BLOCK_SIZE);
+            _overlay_dirty(buffer + i * BLOCK_SIZE, BLOCK_START + block_id_list[i] * BLOCK_SIZE, BLOCK_SIZE);
         }
+    }
 
-        // 如果 working_dir 末尾没有 '/'，则添加一个
-        string absolute_path = working_dir;
-        if (working_dir.back() != '/')
-            absolute_path += "/";
-
-        // 拼接当前工作目录
-        absolute_path += path;
+    // 解压 group_num 组所需的缓冲区大小：压缩数据块读入缓冲区末尾后原地解压，比解压结果多出两块的余量
+    static int _unpack_buffer_size(const int &group_num)
+    {
+        return group_num * PACK_GROUP_SIZE + 2 * BLOCK_SIZE;
+    }
 
-        // 若 absolute_path 末尾为 /.，则去掉
-        if (absolute_path.length() >= 2 && absolute_path.substr(absolute_path.length() - 2) == "/.")
-            absolute_path = absolute_path.substr(0, absolute_path.length() - 2);
+    // 读取压缩流中第 group_begin 至 group_end 组（不含）所在的数据块并解压到 buffer（大小不小于 _unpack_buffer_size），
+    // get_block_id 给出压缩流中第 idx 个数据块的块 ID，返回读取的数据块数
+    // 数据块直接读入 buffer 末尾再从头原地解压，不另行分配和拷贝：压缩数据不超过 5/8 的解压结果加两块，
+    // 其起点距 buffer 开头超过解压结果的 3/8 加一块，满足 unpack_letters 原地解压的要求
+    template <typename GetBlockId>
+    int _unpack_groups(GetBlockId get_block_id, const int &group_begin, const int &group_end, char *buffer)
+    {
+        if (group_begin >= group_end)
+            return 0;
+        const int group_num = group_end - group_begin;
+        const int byte_begin = group_begin * PACK_GROUP_BYTES;
+        const int block_begin = byte_begin / BLOCK_SIZE;
+        const int block_end = (group_end * PACK_GROUP_BYTES + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        vector<short> block_id_list;
+        for (int idx = block_begin; idx < block_end; idx++)
+            block_id_list.push_back(get_block_id(idx));
+        char *packed = buffer + _unpack_buffer_size(group_num) - block_id_list.size() * BLOCK_SIZE;
+        _load_blocks(block_id_list, packed);
+        Util::unpack_letters(packed + byte_begin - block_begin * BLOCK_SIZE, group_num, buffer);
+        return block_id_list.size();
+    }
 
-        // 若中间有 /./，则去掉
-        size_t pos = absolute_path.find("/./");
-        while (pos != string::npos)
+    // 用尚未写回的元数据块与数据块覆盖已从磁盘读出的内容（调用前需持有 journal_mutex）
+    void _overlay_dirty(void *data, int pos, int size)
+    {
+        if (dirty_blocks.empty() && dirty_data_blocks.empty())
+            return;
+        for (int block_no = pos / BLOCK_SIZE; block_no * BLOCK_SIZE < pos + size; block_no++)
         {
-            absolute_path = absolute_path.substr(0, pos) + absolute_path.substr(pos + 2);
-            pos = absolute_path.find("/./");
+            const vector<char> *content = nullptr;
+            if (auto it = dirty_blocks.find(block_no); it != dirty_blocks.end())
+                content = &it->second;
+            else if (auto it = dirty_data_blocks.find(block_no); it != dirty_data_blocks.end())
+                content = &it->second;
+            if (content == nullptr)
+                continue;
+            const int begin = max(pos, block_no * BLOCK_SIZE);
+            const int end = min(pos + size, (block_no + 1) * BLOCK_SIZE);
+            memcpy((char *)data + begin - pos, content->data() + begin - block_no * BLOCK_SIZE, end - begin);
         }
+    }
 
-        // 若 absolute_path 末尾为 /..
-        regex double_dot_pattern("/\\.\\.(/|$)");
-        regex double_dot_valid_pattern("(/[^/]+?/\\.\\.)(/|$)");
-        smatch double_dot_match, double_dot_valid_match;
-        dout << "[获取绝对路径] 双点正则匹配结果：" << regex_search(absolute_path, double_dot_match, double_dot_pattern) << endl;
-        // 若 absolute_path 含有 ..
-        if (regex_search(absolute_path, double_dot_match, double_dot_pattern))
-        {
-            // 若 absolute_path 中的 .. 符合规范
-            if (regex_search(absolute_path, double_dot_valid_match, double_dot_valid_pattern))
-            {
-                dout << "[获取绝对路径] double_dot_valid_match.size(): " << double_dot_valid_match.size() << endl;
-                for (int i = 0; i < double_dot_valid_match.size(); i++)
-                    dout << "[获取绝对路径] double_dot_valid_match[" << i << "]: " << double_dot_valid_match[i] << endl;
-                dout << "[获取绝对路径] double_dot_valid_match.prefix(): " << double_dot_valid_match.prefix() << endl;
-                dout << "[获取绝对路径] double_dot_valid_match.suffix(): " << double_dot_valid_match.suffix() << endl;
-                dout << "[获取绝对路径] double_dot_valid_match.str(): " << double_dot_valid_match.str() << endl;
-                dout << "[获取绝对路径] double_dot_valid_match.position(): " << double_dot_valid_match.position() << endl;
+    int64_t _dirty_bytes() const
+    {
+        return int64_t(dirty_blocks.size() + dirty_data_blocks.size()) * BLOCK_SIZE;
+    }
 
-                // 将 absolute_path 中 double_dot_valid_match[1] 的部分替换为空
-                absolute_path = regex_replace(absolute_path, double_dot_valid_pattern, "/");
-            }
-            else
-            {
-                dout << "[获取绝对路径] 路径" << absolute_path << " 不合法，返回空字符串" << endl;
-                return "";
-            }
+    // 将按块号排序的块写回原位置：块号连续的块不经拷贝直接聚合为一次 pwritev，各段一并交给 I/O 后端，返回写入的字节数
+    int64_t _write_block_runs(const map<int, vector<char>> &blocks)
+    {
+        int64_t bytes = 0;
+        vector<BlockIO::Request> requests;
+        for (auto it = blocks.begin(); it != blocks.end();)
+        {
+            BlockIO::Request &request = requests.emplace_back(int64_t(it->first) * BLOCK_SIZE);
+            for (int block_no = it->first; it != blocks.end() && it->first == block_no && request.iov.size() < IOV_MAX; ++it, ++block_no)
+                request.iov.push_back({const_cast<char *>(it->second.data()), (size_t)BLOCK_SIZE});
+            bytes += request.iov.size() * BLOCK_SIZE;
         }
+        io.write_batch(fd, requests);
+        flush_stats.write_num += requests.size();
 
-        if (absolute_path == "/..")
-            return "/";
-
-        // 若 absolute_path 末尾为 / ，则去掉
-        if (absolute_path.back() == '/')
-            absolute_path = absolute_path.substr(0, absolute_path.length() - 1);
-
-        // 若 absolute_path 为空，则返回 /
-        if (absolute_path.empty())
-            return "/";
-
-        return absolute_path;
+        // 校验和已在提交时更新，原位置上的新内容需重新校验
+        for (const auto &[block_no, content] : blocks)
+            verified_blocks[block_no] = 0;
+        return bytes;
     }
 
-    // 将路径分割为路径向量
-    vector<string> _split_path(const string path)
+    // 日志区由日志记录自带的校验和保护，校验和区本身不校验
+    static bool _has_checksum(const int &block_no)
     {
-        dout << "[路径分割] 原始路径：" << path << endl;
-        string absolute_path = _absolute_path(path);
-        dout << "[路径分割] 绝对路径：" << absolute_path << endl;
-
-        // 分割路径
-        istringstream iss(absolute_path);
-        vector<string> dir_vector;
-        string token;
-        while (getline(iss, token, '/'))
-            if (!token.empty())
-                dir_vector.push_back(token);
-
-        dout << "[路径分割] dir_vector: [";
-        for (const auto &level : dir_vector)
-            dout << level << " ";
-        dout << "]" << endl;
+        return block_no < JOURNAL_START / BLOCK_SIZE || block_no >= BLOCK_START / BLOCK_SIZE;
+    }
 
-        // 形式非法的路径将返回空值
-        return dir_vector;
+    // 块的新内容即将提交或已写回原位置，更新其校验和，所在的校验和区块随下一条日志记录提交（调用前需持有 journal_mutex）
+    void _update_checksum(const int &block_no, const char *content)
+    {
+        block_checksums[block_no] = Util::crc32c(content, BLOCK_SIZE);
+        dirty_checksum_blocks.insert(block_no * sizeof(uint32_t) / BLOCK_SIZE);
+        verified_blocks[block_no] = 0;
     }
 
-    short _search_inode(const short &dir_inode_id, const string &filename)
+    // 按待提交的元数据块更新校验和，并将修改过的校验和区块加入待提交的块，与其对应的内容写入同一条日志记录，
+    // 检查点时一同写回，崩溃后一同重放（调用前需持有 journal_mutex）
+    void _stage_checksums()
     {
-        dout << "[查找 Inode] 正在如下 INode 中查找目录项 " << filename << " ..." << endl;
-        dout << _get_inode(dir_inode_id);
+        for (const auto &block_no : uncommitted_blocks)
+            if (_has_checksum(block_no))
+                _update_checksum(block_no, dirty_blocks[block_no].data());
+        for (const auto &idx : dirty_checksum_blocks)
+        {
+            const char *slice = (const char *)block_checksums.data() + idx * BLOCK_SIZE;
+            const int block_no = CHECKSUM_START / BLOCK_SIZE + idx;
+            dirty_blocks[block_no].assign(slice, slice + BLOCK_SIZE);
+            uncommitted_blocks.insert(block_no);
+        }
+        dirty_checksum_blocks.clear();
+    }
 
-        vector<Dentry> dentry_list = _load_dentries(dir_inode_id);
-        for (const auto &dentry : dentry_list)
-            if (dentry.filename == filename)
-            {
-                dout << "[查找 Inode] 找到目录项 " << filename << "（inode_id: " << dentry.inode_id << "）" << endl;
-                return dentry.inode_id;
-            }
+    // 将修改过的校验和直接写入校验和区（只在日志恢复时使用，其后的检查点保证落盘）
+    void _write_checksums()
+    {
+        for (const auto &idx : dirty_checksum_blocks)
+            _pwrite((const char *)block_checksums.data() + idx * BLOCK_SIZE, CHECKSUM_START + idx * BLOCK_SIZE, BLOCK_SIZE);
+        dirty_checksum_blocks.clear();
+    }
 
-        return -1;
+    // 新建的镜像全部为零
+    void _reset_checksums()
+    {
+        vector<char> zero_block(BLOCK_SIZE, 0);
+        block_checksums.assign(BLOCK_NUM, Util::crc32c(zero_block.data(), BLOCK_SIZE));
+        dirty_checksum_blocks.clear();
+        verified_blocks.assign(BLOCK_NUM, 0);
+        _pwrite(block_checksums.data(), CHECKSUM_START, CHECKSUM_SIZE);
     }
 
-    void _search_inode(const string path, short &dir_inode_id, short &file_inode_id)
+    void _load_checksums()
     {
-        dout << "[查找 Inode] 根据路径 " << path << " 查找 Inode ..." << endl;
+        block_checksums.resize(BLOCK_NUM);
+        dirty_checksum_blocks.clear();
+        verified_blocks.assign(BLOCK_NUM, 0);
+        _pread(block_checksums.data(), CHECKSUM_START, CHECKSUM_SIZE);
+    }
 
-        // 将路径转为路径向量
-        vector<string> dir_vector = _split_path(path);
+    // 用于提示的块名称：数据区内的块按数据块 ID 称呼
+    static string _block_name(const int &block_no)
+    {
+        if (block_no >= BLOCK_START / BLOCK_SIZE)
+            return "data block " + to_string(block_no - BLOCK_START / BLOCK_SIZE);
+        return "metadata block " + to_string(block_no);
+    }
 
-        dir_inode_id = -1;
-        file_inode_id = -1;
+    // 校验刚从原位置读出的块内容（调用前需持有 journal_mutex），不符时报告并计数，内容仍照常返回
+    // 有尚未写回的内容的块，其校验和已对应新内容，原位置上的旧内容会被覆盖，不校验
+    bool _verify_block(const int &block_no, const char *content)
+    {
+        if (block_checksums.empty() || !_has_checksum(block_no) || _is_dirty(block_no))
+            return true;
+        verified_blocks[block_no] = 1;
+        checksum_stats.verified_num++;
+        const uint32_t crc = Util::crc32c(content, BLOCK_SIZE);
+        if (crc == block_checksums[block_no])
+            return true;
+        checksum_stats.error_num++;
+        cout << "[Checksum] " << _block_name(block_no) << " is corrupted (stored " << hex << setw(8) << setfill('0') << block_checksums[block_no] << ", computed " << setw(8) << crc << dec << setfill(' ') << ")" << endl;
+        return false;
+    }
 
-        short ptr_inode_id = ROOT_INODE_ID;
+    // 写回全部脏数据块（调用前需持有 journal_mutex），返回是否有数据写回
+    bool _flush_data()
+    {
+        if (dirty_data_blocks.empty())
+            return false;
+        TRACE_SCOPE("_flush_data");
+        flush_stats.data_bytes += _write_block_runs(dirty_data_blocks);
+        for (const auto &[block_no, content] : dirty_data_blocks)
+            _update_checksum(block_no, content.data());
+        dirty_data_blocks.clear();
+        return true;
+    }
 
-        if (dir_vector.empty())
+    // 关闭事务，累计 JOURNAL_GROUP_COMMIT_NUM 个事务或脏块过多时一并提交
+    // 回写线程运行时交由其提交，命令路径上不再等待写入；待提交的块接近日志容量时立即提交，以免之后的事务继续累积
+    void _end_transaction()
+    {
+        lock_guard<mutex> journal_lock(journal_mutex);
+        if (--transaction_depth > 0)
+            return;
+        if ((int)uncommitted_blocks.size() >= JOURNAL_COMMIT_BLOCK_NUM)
         {
-            dout << "[查找 Inode] 路径为空，返回根目录 Inode ID：" << ptr_inode_id << endl;
-            dir_inode_id = ptr_inode_id;
-            file_inode_id = ptr_inode_id;
+            _journal_commit();
+            return;
         }
+        if (++pending_transaction_num < JOURNAL_GROUP_COMMIT_NUM && _dirty_bytes() < flush_dirty_threshold)
+            return;
 
+        if (flusher.joinable())
+        {
+            flush_requested = true;
+            flusher_cv.notify_one();
+        }
         else
-            for (const auto &level : dir_vector)
-            {
-                // 获取当前目录级别的数据块
-                // dout << "[查找 Inode] 当前目录级别：" << level << endl;
-
-                // 如果非最后一级的 level 不是目录
-                if (_get_inode(ptr_inode_id).file_type != 'd' && &level != &dir_vector.back())
-                {
-                    dout << "[查找 Inode] 当前目录级别不是目录，查找失败！" << endl;
-                    dir_inode_id = -1;
-                    file_inode_id = -1;
-                    return;
-                }
-
-                vector<Dentry> _dentry_list = _load_dentries(ptr_inode_id);
+            _journal_commit();
+    }
 
-                // dout << "[查找 Inode] 当前目录项：" << endl;
-                // for (const auto &dentry : _dentry_list)
-                //     dout << dentry << endl;
+    void disable_async_io()
+    {
+        io.disable_async();
+    }
 
-                // 遍历目录项
-                bool found = false;
-                for (const auto &dentry : _dentry_list)
-                    if (dentry.filename == level)
-                    {
-                        found = true;
-                        dout << "[查找 Inode] 寻找到目录项 " << level << "（inode_id: " << dentry.inode_id << "）" << endl;
-
-                        // 如果还不是最后一个目录项
-                        if (&level != &dir_vector.back())
-                        {
-                            // 则需要继续往下找
-                            ptr_inode_id = dentry.inode_id;
-                            dout << "[查找 Inode] 继续向下一级寻找，ptr_inode_id: " << ptr_inode_id << endl;
-                        }
-                        else
-                        {
-                            // 否则找到了文件
-                            dir_inode_id = ptr_inode_id;
-                            file_inode_id = dentry.inode_id;
-                            dout << "[查找 Inode] 找到了最终项 " << level << "，此时 dir_inode_id: " << dir_inode_id << "，file_inode_id: " << file_inode_id << endl;
-                        }
-                        break;
-                    }
+    // 镜像是否已挂载：版本或几何参数不兼容而拒绝挂载时为 false，此时只能用 mkfs 或 erase 重新格式化
+    bool is_mounted() const
+    {
+        return fd != -1;
+    }
 
-                if (!found)
-                {
-                    // 找到了次末级目录，但是没有找到最终项（文件/文件夹）
-                    // 如果是最后一个，则说明文件不存在，否则说明目录不存在
-                    if (&level == &dir_vector.back())
-                    {
-                        dir_inode_id = ptr_inode_id;
-                        file_inode_id = -1;
-                        dout << "[查找 Inode] 文件 " << level << " 不存在" << endl;
-                    }
-                    else
-                    // 否则则是在中途找不到目录的情况
-                    {
-                        dir_inode_id = -1;
-                        file_inode_id = -1;
-                        dout << "[查找 Inode] 目录 " << level << " 不存在" << endl;
-                    }
-                    return;
-                }
-            }
+    // 之后新建的文件压缩存放
+    void enable_compression()
+    {
+        compress_new_files = true;
+    }
 
-        dout << "[查找 Inode] 根据路径查找 Inode 结果：" << endl;
-        dout << "[查找 Inode] dir_inode_id: " << dir_inode_id << endl;
-        dout << "[查找 Inode] file_inode_id: " << file_inode_id << endl;
+    // 原地按 new_geometry 重新格式化镜像：丢弃全部未写回的内容后重建，回写线程暂停期间完成，不重新启动进程
+    // 镜像无法创建时返回 false，此时镜像已关闭，只能再次格式化
+    bool format(const Geometry new_geometry)
+    {
+        TRACE_SCOPE("format");
+        const bool flusher_running = flusher.joinable();
+        _stop_flusher();
+        geometry = new_geometry;
+        if (!_create_filesys())
+            return false;
+        _set_mount_state(1);
+        _init_working_dir();
+        if (flusher_running)
+            start_flusher(flush_interval_ms, flush_dirty_threshold);
+        return true;
     }
 
-    string _filename(const string path)
+    // 以指定的镜像大小、块大小与每个 INode 对应的字节数格式化镜像
+    // bytes_per_inode 为 0 时按默认的每 2KB 一个 INode 计算，并限制在 INode ID 可表示的范围内
+    bool mkfs(const int &filesystem_size, const int &block_size, const int &bytes_per_inode = 0)
     {
-        vector<string> dir_vector = _split_path(path);
-        if (dir_vector.empty())
-            return "";
-        else
+        if (filesystem_size <= 0 || block_size <= 0 || bytes_per_inode < 0)
         {
-            dout << "文件名为 " << dir_vector.back() << endl;
-            return dir_vector.back();
+            cout << "mkfs: sizes must be positive" << endl;
+            return false;
+        }
+        // INode 数向下取整到分配组与 bitmap 字节对齐
+        int inode_num = filesystem_size / (bytes_per_inode > 0 ? bytes_per_inode : DEFAULT_BYTES_PER_INODE);
+        if (bytes_per_inode == 0)
+            inode_num = min(inode_num, SHRT_MAX);
+        inode_num = inode_num / (8 * GROUP_NUM) * (8 * GROUP_NUM);
+        const Geometry new_geometry(filesystem_size, block_size, inode_num);
+        const string error = new_geometry.validate();
+        if (!error.empty())
+        {
+            cout << "mkfs: " << error << endl;
+            return false;
         }
+        if (!format(new_geometry))
+            return false;
+        cout << "mkfs: " << Util::readable_size(FILESYSTEM_SIZE) << " image, " << Util::readable_size(BLOCK_SIZE) << " blocks, " << DATA_BLOCK_NUM << " data blocks, " << INODE_NUM << " inodes, metadata "
+             << Util::readable_size(BLOCK_START) << ", max file size " << Util::readable_size(MAX_FILE_SIZE) << endl;
+        return true;
     }
 
-    void _add_dentry(INode &dir_inode, const short &new_inode_id, const string &filename)
+    // 启动后台回写线程
+    void start_flusher(const int &interval_ms = FLUSH_INTERVAL_MS, const int &dirty_threshold = FLUSH_DIRTY_THRESHOLD)
     {
-        dout << "[新增目录项] 正在向如下 INode 新增目录项 " << filename << "（INode ID 为" << new_inode_id << "）..." << endl;
-        dout << dir_inode << endl;
+        lock_guard<mutex> journal_lock(journal_mutex);
+        if (flusher.joinable())
+            return;
+        flush_interval_ms = interval_ms;
+        flush_dirty_threshold = dirty_threshold;
+        flusher_stop = false;
+        flusher = thread(&FileSystem::_flusher_loop, this);
+    }
 
-        if (dir_inode.file_type != 'd')
+    void _stop_flusher()
+    {
         {
-            dout << "[新增目录项] 该 INode 不是目录，新增目录项失败！" << endl;
-            return;
+            lock_guard<mutex> journal_lock(journal_mutex);
+            flusher_stop = true;
         }
+        flusher_cv.notify_one();
+        if (flusher.joinable())
+            flusher.join();
+    }
 
-        // 获取当前目录的数据块
-        vector<short> block_id_list = _get_block_list(dir_inode);
-        dout << "[新增目录项] 该 INode 对应的 Dentry 数据块个数：" << block_id_list.size() << endl;
-
-        // 遍历数据块，找到第一个空闲的 Dentry 位置
-        bool found = false;
-        for (const auto &block_id : block_id_list)
+    // 回写线程：每隔 flush_interval_ms 或被请求时提交已关闭的事务；定时唤醒或脏块过多时顺带做检查点
+    void _flusher_loop()
+    {
+        unique_lock<mutex> journal_lock(journal_mutex);
+        while (!flusher_stop)
         {
-            dout << "[新增目录项] 读取 Dentry 数据块 " << block_id << " ..." << endl;
-            vector<Dentry> dentry_list(DENTRY_NUM_PER_BLOCK);
-            _load(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+            const bool requested = flusher_cv.wait_for(journal_lock, chrono::milliseconds(flush_interval_ms), [this]
+                                                       { return flusher_stop || flush_requested; });
+            if (flusher_stop)
+                break;
 
-            for (int i = 0; i < DENTRY_NUM_PER_BLOCK; i++)
-            {
-                dout << "[新增目录项] Dentry 数据块 " << block_id << " 的第 " << i << " 个 Dentry：" << dentry_list[i].inode_id << "  " << dentry_list[i].get_filename() << endl;
-                if (dentry_list[i].inode_id == -1)
-                {
-                    found = true;
+            flush_stats.wakeup_num++;
+            flush_requested = false;
+            // 有事务尚未关闭时不提交，以免提交半个操作；事务关闭时会再次请求
+            if (transaction_depth > 0)
+                continue;
 
-                    // 设置 Dentry
-                    dentry_list[i] = Dentry(new_inode_id, filename);
-                    dout << "[新增目录项] Dentry 数据块 " << block_id << " 的第 " << i << " 个 Dentry 为空，已设置为 " << endl;
-                    dout << dentry_list[i] << endl;
-                    _dump(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+            TRACE_SCOPE("_flusher_loop");
+            _journal_commit();
+            if (!requested || _dirty_bytes() >= flush_dirty_threshold)
+                _journal_checkpoint();
+        }
+    }
 
-                    // INode 硬链接数加 1
-                    INode _inode = _get_inode(new_inode_id);
-                    _inode.link_cnt++;
-                    _save_inode(_inode);
+    // 由多个步骤组成的命令（递归复制、递归删除）在两步之间调用，此时元数据是一致的
+    // 待提交的块接近日志容量时先提交已完成的步骤，使单条记录始终能放入日志区；崩溃后保留已完成的步骤
+    void _commit_between_steps()
+    {
+        lock_guard<mutex> journal_lock(journal_mutex);
+        if (transaction_depth <= 1 && (int)uncommitted_blocks.size() >= JOURNAL_COMMIT_BLOCK_NUM)
+        {
+            dout << "[日志] 待提交的块数 " << uncommitted_blocks.size() << " 接近日志容量，提交已完成的步骤" << endl;
+            _journal_commit();
+        }
+    }
 
-                    dout << "[新增目录项] 新增目录项成功！" << endl;
-                    return;
-                }
+    // 提交：将自上次提交以来修改过的全部元数据块作为一条日志记录顺序写入日志区（调用前需持有 journal_mutex）
+    void _journal_commit()
+    {
+        TRACE_SCOPE("_journal_commit");
+        pending_transaction_num = 0;
+        // 日志中仍有已复用为数据块的块的旧元数据时，先做检查点清空日志，以免检查点或崩溃后重放用旧内容覆盖新数据
+        for (const auto &[block_no, content] : dirty_data_blocks)
+            if (committed_blocks.count(block_no))
+            {
+                dout << "[日志] 块 " << block_no << " 由元数据复用为数据块，写回数据前先做检查点" << endl;
+                _journal_checkpoint();
+                break;
             }
+        const bool data_flushed = _flush_data();
+        allocated_blocks.clear();
+        _stage_checksums();
+        if (uncommitted_blocks.empty())
+        {
+            if (data_flushed)
+                fdatasync(fd);
+            _discard_freed_blocks();
+            return;
         }
 
-        if (!found)
+        const int block_num = uncommitted_blocks.size();
+        const int descriptor_block_num = JournalDescriptor::block_num_for(block_num);
+
+        // 单条记录超过日志区容量（单个步骤修改的块过多），无法保证原子性，退化为直接写回原位置
+        // 挂载期间磁盘上超级块的挂载标记为 1，超级块最后写回（卸载时才会清 0），写到一半时崩溃的话下次启动会检查并修复
+        if (descriptor_block_num + block_num > JOURNAL_BLOCK_NUM - 1)
         {
-            dout << "[新增目录项] 该 INode 目前没有空闲的 Dentry 位置，新增 Dentry 块中 ..." << endl;
-            // 遍历 INode 的直接块
-            for (int i = 0; i < NUM_DIRECT_BLOCK; i++)
-            {
-                if (dir_inode.direct_block[i] == -1)
-                {
-                    dir_inode.direct_block[i] = _get_avail_block();
-                    _create_blank_dentries(dir_inode.direct_block[i]);
-                    dout << "[新增目录项] 直接块 " << i << " 为空，新增 Dentry 数据块：" << dir_inode.direct_block[i] << endl;
-                    // INode 的文件大小增加一个数据块的大小
-                    dir_inode.file_size += BLOCK_SIZE;
-                    _save_inode(dir_inode);
-                    _add_dentry(dir_inode, new_inode_id, filename);
-                    return;
-                }
-            }
-            // 遍历 INode 的间接块
-            for (int i = 0; i < NUM_INDIRECT_BLOCK; i++)
+            dout << "[日志] 提交的块数 " << block_num << " 超过日志容量，直接写回原位置" << endl;
+            _journal_checkpoint();
+            const int superblock_no = SUPERBLOCK_START / BLOCK_SIZE;
+            map<int, vector<char>> blocks;
+            for (const auto &block_no : uncommitted_blocks)
+                if (block_no != superblock_no)
+                    blocks[block_no] = dirty_blocks[block_no];
+            flush_stats.metadata_bytes += _write_block_runs(blocks);
+            fdatasync(fd);
+            if (uncommitted_blocks.count(superblock_no))
             {
-                if (dir_inode.indirect_block[i] == -1)
-                {
-                    // 申请新的地址数据块
-                    dir_inode.indirect_block[i] = _get_avail_block();
-                    dout << "[新增目录项] 间接块 " << i << " 为空，新增 Address 数据块：" << dir_inode.indirect_block[i] << endl;
-                    // 初始化新的地址数据块
-                    vector<short> addr(ADDRESS_PER_BLOCK, -1);
-                    addr[0] = _get_avail_block();
-                    // 初始化 Dentry 数据块
-                    _create_blank_dentries(addr[0]);
-                    dout << "[新增目录项] 间接块 " << i << " 的第 0 个地址为空，新增 Dentry 数据块：" << addr[0] << endl;
-                    _dump(addr.data(), BLOCK_START + dir_inode.indirect_block[i] * BLOCK_SIZE, BLOCK_SIZE);
-                    // INode 文件大小随着地址数据块的新增而增长
-                    dir_inode.file_size += BLOCK_SIZE;
-                    _save_inode(dir_inode);
-                    _add_dentry(dir_inode, new_inode_id, filename);
-                    return;
-                }
-                else
-                {
-                    dout << "[新增目录项] 间接块 " << i << " 不为空，读取 Address 数据块：" << dir_inode.indirect_block[i] << endl;
-                    vector<short> addr(ADDRESS_PER_BLOCK);
-                    _load(addr.data(), BLOCK_START + dir_inode.indirect_block[i] * BLOCK_SIZE, BLOCK_SIZE);
-                    for (int j = 0; j < ADDRESS_PER_BLOCK; j++)
-                    {
-                        if (addr[j] == -1)
-                        {
-                            addr[j] = _get_avail_block();
-                            _create_blank_dentries(addr[j]);
-                            dout << "[新增目录项] 间接块 " << i << " 的第 " << j << " 个地址为空，新增 Dentry 数据块：" << addr[j] << endl;
-                            _dump(addr.data(), BLOCK_START + dir_inode.indirect_block[i] * BLOCK_SIZE, BLOCK_SIZE);
-                            dir_inode.file_size += BLOCK_SIZE;
-                            _save_inode(dir_inode);
-                            _add_dentry(dir_inode, new_inode_id, filename);
-                            return;
-                        }
-                    }
-                }
+                flush_stats.metadata_bytes += _write_block_runs({{superblock_no, dirty_blocks[superblock_no]}});
+                fdatasync(fd);
             }
+            for (const auto &block_no : uncommitted_blocks)
+                dirty_blocks.erase(block_no);
+            uncommitted_blocks.clear();
+            _discard_freed_blocks();
+            return;
         }
-    };
 
-    void _add_dentry(const short &dir_inode_id, const short &new_inode_id, const string &filename)
+        // 日志区剩余空间不足时先做检查点，清空日志
+        if (journal_used_block_num + descriptor_block_num + block_num > JOURNAL_BLOCK_NUM - 1)
+            _journal_checkpoint();
+
+        // 描述块 + 元数据块，一次顺序写入
+        vector<char> record((descriptor_block_num + block_num) * BLOCK_SIZE, 0);
+        JournalDescriptor descriptor;
+        descriptor.sequence = journal_sequence;
+        descriptor.block_num = block_num;
+        vector<int32_t> block_no_list(uncommitted_blocks.begin(), uncommitted_blocks.end());
+        for (int i = 0; i < block_num; i++)
+        {
+            vector<char> &content = committed_blocks[block_no_list[i]] = dirty_blocks[block_no_list[i]];
+            memcpy(record.data() + (descriptor_block_num + i) * BLOCK_SIZE, content.data(), BLOCK_SIZE);
+        }
+        descriptor.checksum = JournalDescriptor::compute_checksum(block_no_list, record.data() + descriptor_block_num * BLOCK_SIZE);
+        memcpy(record.data(), &descriptor, sizeof(descriptor));
+        memcpy(record.data() + sizeof(descriptor), block_no_list.data(), block_num * sizeof(int32_t));
+
+        // 先落盘此前直接写入的文件数据，再写日志记录，保证元数据不会指向未落盘的数据
+        fdatasync(fd);
+        _pwrite(record.data(), JOURNAL_START + (1 + journal_used_block_num) * BLOCK_SIZE, record.size());
+        fdatasync(fd);
+        flush_stats.commit_num++;
+        flush_stats.journal_bytes += record.size();
+        flush_stats.write_num++;
+
+        dout << "[日志] 提交记录 " << journal_sequence << "，共 " << block_num << " 个元数据块" << endl;
+        journal_sequence++;
+        journal_used_block_num += descriptor_block_num + block_num;
+        uncommitted_blocks.clear();
+        _discard_freed_blocks();
+    }
+
+    // 主机页大小（不小于块大小），打洞以整页为单位
+    static int _host_page_size()
     {
-        INode dir_inode = _get_inode(dir_inode_id);
-        _add_dentry(dir_inode, new_inode_id, filename);
+        static const int host_page_size = sysconf(_SC_PAGESIZE);
+        return max(host_page_size, BLOCK_SIZE);
     }
 
-    void _remove_dentry(const short &dir_inode_id, const short &inode_id)
+    // 释放已提交的数据块所在的主机页若已全部空闲则打洞（调用前需持有 journal_mutex）
+    // 释放提交之前打洞的话，崩溃后重放出的元数据仍会引用已被清零的块，因此只在提交之后进行
+    void _discard_freed_blocks()
     {
-        vector<short> block_id_list = _get_block_list(dir_inode_id);
-        vector<Dentry> dentry_list(DENTRY_NUM_PER_BLOCK);
-        for (const auto &block_id : block_id_list)
-        {
-            _load(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
-            for (auto &dentry : dentry_list)
-                // 找到了需要删除的目录项
-                if (dentry.inode_id == inode_id)
-                {
-                    dentry = Dentry();
-                    _dump(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+        if (transaction_depth > 0)
+            return;
+        _punch_freed_blocks();
+    }
 
-                    // 文件自身硬链接数减一
-                    INode inode = _get_inode(inode_id);
-                    inode.link_cnt--;
-                    _save_inode(inode);
-                    dout << "[删除目录项] 目录项对应的 INode 硬链接数减 1：" << endl
-                         << inode;
+    // 对 freed_blocks 所在的主机页打洞并清空 freed_blocks，其中的块此后可以重新分配（调用前需持有 journal_mutex）
+    void _punch_freed_blocks()
+    {
+        if (freed_blocks.empty())
+            return;
+        set<int> page_list;
+        for (const auto &block_id : freed_blocks)
+            page_list.insert((BLOCK_START + block_id * BLOCK_SIZE) / _host_page_size());
+        freed_blocks.clear();
+        _punch_pages(page_list);
+    }
 
-                    // 如果是目录，父目录的硬链接数减一
-                    if (_get_inode(inode_id).file_type == 'd')
-                    {
-                        INode dir_inode = _get_inode(dir_inode_id);
-                        dir_inode.link_cnt--;
-                        _save_inode(dir_inode);
-                        dout << "[删除目录项] 目录项为目录，其父目录的 INode 硬链接数减 1：" << endl
-                             << dir_inode;
-                    }
+    // 对 page_list 中全部块均空闲的主机页打洞，相邻的页合并为一次 fallocate，打洞后的块读出均为 0（调用前需持有 journal_mutex）
+    bool _punch_pages(const set<int> &page_list)
+    {
+        const int page_size = _host_page_size();
+        const int blocks_per_page = page_size / BLOCK_SIZE;
+        auto page_free = [&](const int &page)
+        {
+            for (int block_no = page * blocks_per_page; block_no < (page + 1) * blocks_per_page; block_no++)
+            {
+                const int block_id = block_no - BLOCK_START / BLOCK_SIZE;
+                if (block_id < 0 || block_id >= DATA_BLOCK_NUM || block_bitmap.get(block_id) || uncommitted_blocks.count(block_no))
+                    return false;
+            }
+            return true;
+        };
 
-                    return;
-                }
+        const vector<char> zero_block(BLOCK_SIZE, 0);
+        bool punched = true;
+        for (auto it = page_list.begin(); it != page_list.end();)
+        {
+            if (!page_free(*it))
+            {
+                ++it;
+                continue;
+            }
+            const int first_page = *it;
+            int last_page = first_page;
+            for (++it; it != page_list.end() && *it == last_page + 1 && page_free(*it); ++it)
+                last_page++;
+
+            const off_t offset = (off_t)first_page * page_size;
+            const off_t length = (off_t)(last_page - first_page + 1) * page_size;
+            if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, length) != 0)
+            {
+                dout << "[打洞] 打洞失败：" << strerror(errno) << endl;
+                punched = false;
+                break;
+            }
+            // 空闲块中残留的元数据不再写回，校验和改为全零块的校验和
+            for (int block_no = first_page * blocks_per_page; block_no < (last_page + 1) * blocks_per_page; block_no++)
+            {
+                dirty_blocks.erase(block_no);
+                committed_blocks.erase(block_no);
+                _update_checksum(block_no, zero_block.data());
+            }
+            flush_stats.punch_num++;
+            flush_stats.punched_bytes += length;
         }
+        return punched;
     }
 
-    vector<Dentry> _load_dentries(const INode &inode)
+    // 检查点：将已提交的元数据块写回原位置，然后清空日志（调用前需持有 journal_mutex）
+    void _journal_checkpoint()
     {
-        dout << "[读取目录项] 读取如下 INode 的目录项 ..." << endl;
-        dout << inode << endl;
-
-        if (inode.file_type != 'd')
+        TRACE_SCOPE("_journal_checkpoint");
+        if (!committed_blocks.empty())
         {
-            dout << "[读取目录项] 该 INode 不是目录，读取失败！" << endl;
-            return {};
+            flush_stats.metadata_bytes += _write_block_runs(committed_blocks);
+            flush_stats.checkpoint_num++;
+            fdatasync(fd);
+            dout << "[日志] 检查点写回 " << committed_blocks.size() << " 个元数据块" << endl;
+
+            // 提交后未再修改的块已与磁盘一致，不再需要保留
+            for (const auto &[block_no, content] : committed_blocks)
+                if (!uncommitted_blocks.count(block_no))
+                    dirty_blocks.erase(block_no);
+            committed_blocks.clear();
         }
 
-        vector<short> block_id_list = _get_block_list(inode);
-        dout << "[读取目录项] 该 INode 对应的 Dentry 数据块：" << block_id_list << endl;
-
-        vector<Dentry> dentry_list;
-        for (const auto &block_id : block_id_list)
+        if (journal_used_block_num > 0)
         {
-            // dout << "[读取目录项] 读取 Dentry 数据块 " << block_id << " ..." << endl;
-            vector<Dentry> dentry(DENTRY_NUM_PER_BLOCK);
-            _load(dentry.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
-            // dout << "[读取目录项] 读取 Dentry 数据块 " << block_id << " 结果：" << endl
-            //      << dentry << endl;
-
-            for (const auto &entry : dentry)
-                if (entry.inode_id != -1)
-                    dentry_list.push_back(entry);
+            _reset_journal();
+            fdatasync(fd);
         }
-
-        // dout << "[读取目录项] 有效 Dentry：" << endl
-        //      << dentry_list << endl;
-        return dentry_list;
     }
 
-    vector<Dentry> _load_dentries(short inode_id)
+    // 日志头记录第一条有效记录的序号，序号前移即可使旧记录全部失效
+    void _reset_journal()
     {
-        INode inode = _get_inode(inode_id);
-        return _load_dentries(inode);
+        JournalHeader header;
+        header.sequence = journal_sequence;
+        _pwrite(&header, JOURNAL_START, sizeof(header));
+        journal_used_block_num = 0;
     }
 
-    void _save_inode(const short &inode_id, const char &file_type, const int &file_size)
+    // 提交全部事务并做检查点
+    void _journal_flush()
     {
-        dout << "[保存 Inode] 保存如下 Inode ..." << endl;
-        INode inode = INode();
-        inode.id = inode_id;
-        inode.file_type = file_type;
-        inode.file_size = file_size;
-        inode.create_time = Util::get_current_time();
-        inode.modify_time = Util::get_current_time();
-        dout << inode;
-        _dump(&inode, INODE_TABLE_START + inode_id * INODE_SIZE, INODE_CLASS_SIZE);
+        lock_guard<mutex> journal_lock(journal_mutex);
+        _journal_commit();
+        _journal_checkpoint();
     }
 
-    void _save_inode(const INode &inode)
+    // 启动时重放日志中已完整提交的记录，返回重放的记录数
+    int _journal_recover()
     {
-        _dump(&inode, INODE_TABLE_START + inode.id * INODE_SIZE, INODE_CLASS_SIZE);
+        TRACE_SCOPE("_journal_recover");
+        JournalHeader header;
+        _pread(&header, JOURNAL_START, sizeof(header));
+        journal_sequence = header.magic == JOURNAL_MAGIC ? header.sequence : 0;
+
+        int replayed_num = 0;
+        int offset = 0;
+        vector<char> block(BLOCK_SIZE);
+        while (offset < JOURNAL_BLOCK_NUM - 1)
+        {
+            const int record_pos = JOURNAL_START + (1 + offset) * BLOCK_SIZE;
+            JournalDescriptor descriptor;
+            _pread(&descriptor, record_pos, sizeof(descriptor));
+            if (descriptor.magic != JOURNAL_MAGIC || descriptor.sequence != journal_sequence || descriptor.block_num <= 0)
+                break;
+
+            const int descriptor_block_num = JournalDescriptor::block_num_for(descriptor.block_num);
+            if (offset + descriptor_block_num + descriptor.block_num > JOURNAL_BLOCK_NUM - 1)
+                break;
+
+            // 校验和不符说明记录未完整写入（提交时崩溃），其后不会再有有效记录
+            vector<char> record((descriptor_block_num + descriptor.block_num) * BLOCK_SIZE);
+            _pread(record.data(), record_pos, record.size());
+            vector<int32_t> block_no_list(descriptor.block_num);
+            memcpy(block_no_list.data(), record.data() + sizeof(descriptor), descriptor.block_num * sizeof(int32_t));
+            if (JournalDescriptor::compute_checksum(block_no_list, record.data() + descriptor_block_num * BLOCK_SIZE) != descriptor.checksum)
+                break;
+
+            // 记录中的校验和区块直接载入；其余块按重放的内容重新计算校验和，兼容不含校验和区块的记录
+            for (int i = 0; i < descriptor.block_num; i++)
+            {
+                const int block_no = block_no_list[i];
+                const char *content = record.data() + (descriptor_block_num + i) * BLOCK_SIZE;
+                _pwrite(content, block_no * BLOCK_SIZE, BLOCK_SIZE);
+                if (_has_checksum(block_no))
+                    _update_checksum(block_no, content);
+                else if (block_no >= CHECKSUM_START / BLOCK_SIZE)
+                    memcpy((char *)block_checksums.data() + (block_no - CHECKSUM_START / BLOCK_SIZE) * BLOCK_SIZE, content, BLOCK_SIZE);
+            }
+            _write_checksums();
+
+            dout << "[日志恢复] 重放记录 " << journal_sequence << "，共 " << descriptor.block_num << " 个元数据块" << endl;
+            journal_sequence++;
+            offset += descriptor_block_num + descriptor.block_num;
+            replayed_num++;
+        }
+
+        if (replayed_num > 0)
+            fdatasync(fd);
+        _reset_journal();
+        fdatasync(fd);
+        return replayed_num;
     }
 
-    INode _get_inode(const short &inode_id)
+    void _close_image()
     {
-        INode inode = INode();
-        _load(&inode, INODE_TABLE_START + inode_id * INODE_SIZE, INODE_CLASS_SIZE);
-        assert(inode.id == inode_id);
-        return inode;
+        if (fd != -1)
+            close(fd);
+        fd = -1;
     }
 
-    const vector<short> _inode_cnt(const short &inode_id)
+    // 丢弃内存中全部未写回的元数据与日志状态
+    void _clear_journal_state()
     {
-        vector<short> cnt;
-        const INode inode = _get_inode(inode_id);
+        dirty_blocks.clear();
+        committed_blocks.clear();
+        uncommitted_blocks.clear();
+        dirty_data_blocks.clear();
+        freed_blocks.clear();
+        pending_transaction_num = 0;
+        journal_used_block_num = 0;
+    }
 
-        // 文件
-        if (inode.file_type != 'd')
-            cnt.push_back(inode.id);
+    // 创建文件系统：镜像截断后扩展为稀疏文件，未写入的区域读出均为 0，无需逐字节清零，
+    // 只写入超级块、bitmap、校验和区、日志头以及根目录的 INode 与目录项块
+    // 镜像无法创建或扩展时返回 false 并关闭镜像，此时视为未挂载
+    bool _create_filesys()
+    {
+        superblock = SuperBlock();
+        block_bitmap = Bitmap(BLOCK_BITMAP_SIZE);
+        inode_bitmap = Bitmap(INODE_BITMAP_SIZE);
 
-        else if (inode.file_type == 'd')
+        _close_image();
+        fd = open(image_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1 || ftruncate(fd, FILESYSTEM_SIZE) != 0)
         {
-            cnt.push_back(inode.id);
-            vector<Dentry> dentry_list = _load_dentries(inode);
-            for (const auto &dentry : dentry_list)
-                if (dentry.inode_id != -1 && dentry.get_filename() != "." && dentry.get_filename() != "..")
-                {
-                    vector<short> temp = _inode_cnt(dentry.inode_id);
-                    cnt.insert(cnt.end(), temp.begin(), temp.end());
-                }
+            cout << "[Init] Cannot create " << image_path << ": " << strerror(errno) << endl;
+            _close_image();
+            _clear_journal_state();
+            return false;
         }
+        _reset_checksums();
+        _clear_journal_state();
+        journal_sequence = 0;
+        _reset_journal();
+
+        dentry_filters.clear();
+        link_dirs.clear();
+        link_dirs_ready = false;
+        _init_alloc_groups();
+        _dump_header();
 
-        return cnt;
+        _init_root_dir();
+        _journal_flush();
+        return true;
     }
 
-    const short inode_cnt(const short &inode_id)
+    // 初始化根目录
+    void _init_root_dir()
     {
-        dout << "[统计 Inode 数量] 正在统计 " << inode_id << " 的占用总 Inode 数 ..." << endl;
-        vector<short> cnt = _inode_cnt(inode_id);
-        dout << "[统计 Inode 数量] INode 列表: " << cnt << endl;
-        unordered_set<short> unique_cnt(cnt.begin(), cnt.end());
-        short sum = 0;
-        for (const auto &id : unique_cnt)
-            sum++;
-        dout << "[统计 Inode 数量] INode 数量: " << sum << endl;
-        return sum;
+        dout << "[初始化根目录] 准备初始化 ..." << endl;
+
+        // Inode
+        _save_inode(_get_avail_inode(), 'd', BLOCK_SIZE);
+        alloc_groups[_inode_group(ROOT_INODE_ID)].dir_num++;
+        // 数据块
+        _create_blank_dentries(_get_avail_block(), ROOT_INODE_ID, ROOT_INODE_ID);
+
+        dout << "[初始化根目录] 初始化完成！" << endl;
     }
 
-    const short block_cnt(const short &inode_id)
+    void _init_working_dir()
     {
-        dout << "[统计块数量] 正在统计 " << inode_id << " 的占用总块数 ..." << endl;
+        working_dir = "/";
+        working_dir_inode_id = ROOT_INODE_ID;
+        dout << "[初始化工作目录] 当前工作目录为 " << working_dir << "（INode ID 为 " << working_dir_inode_id << "）" << endl;
+    }
 
-        short cnt = 0;
-        vector<short> inode_list = _inode_cnt(inode_id);
-        unordered_set<short> unique_inode_list(inode_list.begin(), inode_list.end());
-        for (const auto &inode_id : unique_inode_list)
-        {
-            const INode inode = _get_inode(inode_id);
-            // 计数加上数据块块数和地址块块数
-            cnt += inode.file_size / BLOCK_SIZE + _get_addr_block_list(inode).size();
-        }
+    bool _is_filesys_exist()
+    {
+        ifstream file(image_path);
+        bool exist = file.good();
+        file.close();
+        return exist;
+    }
 
-        dout << "[统计块数量] INode " << inode_id << " 占用总块数：" << cnt << endl;
-        return cnt;
+    void _load_header()
+    {
+        _load(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
+        _load(block_bitmap.bitmap.data(), BLOCK_BITMAP_START, BLOCK_BITMAP_SIZE);
+        _load(inode_bitmap.bitmap.data(), INODE_BITMAP_START, INODE_BITMAP_SIZE);
     }
 
-    string _load_file(const INode &inode)
+    // 记录挂载状态并立即落盘：挂载时置 1，正常卸载时（析构时）清 0
+    void _set_mount_state(const int state)
     {
-        dout << "[加载文件] 加载如下 INode 的文件内容 ..." << endl;
-        dout << inode << endl;
+        superblock.mount_state = state;
+        _dump(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
+        _journal_flush();
+    }
 
-        vector<short> block_id_list = _get_block_list(inode);
+    void _dump_header()
+    {
+        _sync_superblock_counters();
+        _dump(&superblock, SUPERBLOCK_START, SUPERBLOCK_CLASS_SIZE);
+        _dump(block_bitmap.bitmap.data(), BLOCK_BITMAP_START, BLOCK_BITMAP_SIZE);
+        _dump(inode_bitmap.bitmap.data(), INODE_BITMAP_START, INODE_BITMAP_SIZE);
+    }
 
-        dout << "[加载文件] 该文件有 " << block_id_list.size() << " 个数据块：" << endl;
-        for (const auto &block_id : block_id_list)
-            dout << block_id << " ";
-        dout << endl;
+    // 由 bitmap 与 INode 表统计各分配组的空闲块数、空闲 INode 数与目录数
+    void _init_alloc_groups()
+    {
+        alloc_groups.assign(GROUP_NUM, AllocGroup());
 
-        string file_data_str;
-        file_data_str.reserve(inode.file_size);
-        for (const auto &block_id : block_id_list)
+        for (int i = 0; i < DATA_BLOCK_NUM; i++)
+            if (!block_bitmap.get(i))
+                alloc_groups[_block_group(i)].free_block_num++;
+
+        vector<char> inode_table(INODE_TABLE_SIZE);
+        _load(inode_table.data(), INODE_TABLE_START, INODE_TABLE_SIZE);
+        for (int i = 0; i < INODE_NUM; i++)
         {
-            vector<char> content(BLOCK_SIZE);
-            _load(content.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
-            // dout << "[加载文件] 读取数据块 " << block_id << " 内容：" << endl
-            //      << content << endl;
-            file_data_str.append(content.data(), BLOCK_SIZE);
-            // unique_ptr<char[]> block(new char[BLOCK_SIZE]);
-            // _load(block.get(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
-            // file_data_str.append(block.get(), BLOCK_SIZE);
+            if (!inode_bitmap.get(i))
+                alloc_groups[_inode_group(i)].free_inode_num++;
+            else if (inode_table[i * INODE_SIZE + offsetof(INode, file_type)] == 'd')
+                alloc_groups[_inode_group(i)].dir_num++;
         }
+        _init_tail_blocks(inode_table);
+        _init_block_refs(inode_table);
 
-        return file_data_str;
+        // 以 bitmap 为准修正超级块中的计数（上次未正常退出时超级块可能未及时写回）
+        _sync_superblock_counters();
     }
 
-    const short _create_file(const short &dir_inode_id, const string &filename, const int &filesize_kb)
+    // 由 INode 表中各文件的尾部片段重建打包块的槽位占用
+    void _init_tail_blocks(const vector<char> &inode_table)
     {
-        short new_inode_id = _get_avail_inode();
-        dout << "[创建文件] 已申请新 Inode：" << new_inode_id << endl;
-
-        // Inode
-        _save_inode(new_inode_id, 'f', filesize_kb * 1024);
-
-        // 目录项
-        _add_dentry(dir_inode_id, new_inode_id, filename);
-
-        // 数据块
-        vector<short> block_id_list;
-        for (int i = 0; i < filesize_kb; i++)
+        tail_blocks.clear();
+        for (int i = 0; i < INODE_NUM; i++)
         {
-            short id = _get_avail_block();
-            block_id_list.push_back(id);
-            dout << "[创建文件] 已申请第 " << i << " 个块：" << id << endl;
+            if (!inode_bitmap.get(i))
+                continue;
+            INode inode;
+            memcpy(&inode, &inode_table[i * INODE_SIZE], INODE_CLASS_SIZE);
+            if (inode.file_type == 'f' && inode.tail_block != -1)
+                _mark_tail(inode, true);
         }
-        _set_block_list(new_inode_id, block_id_list);
+    }
 
-        // 向数据块写入随机内容
-        srand(static_cast<unsigned int>(time(0)));
-        for (const auto &id : block_id_list)
+    // 统计各文件引用的数据块，重建共享块的引用数
+    void _init_block_refs(const vector<char> &inode_table)
+    {
+        block_refs.clear();
+        unordered_map<short, int> ref_cnt;
+        for (int i = 0; i < INODE_NUM; i++)
         {
-            vector<char> content(BLOCK_SIZE);
-            for (int i = 0; i < BLOCK_SIZE; i++)
-                content[i] = 'a' + rand() % 26;
-            // content[i] = '0' + i % 10;
-            // dout << "[创建文件] 写入数据块 " << id << " 内容：" << endl
-            //      << content << endl;
-            _dump(content.data(), BLOCK_START + id * BLOCK_SIZE, BLOCK_SIZE);
+            if (!inode_bitmap.get(i) || inode_table[i * INODE_SIZE + offsetof(INode, file_type)] != 'f')
+                continue;
+            INode inode;
+            memcpy(&inode, &inode_table[i * INODE_SIZE], INODE_CLASS_SIZE);
+            if (Util::data_block_num(inode.file_size) == 0)
+                continue;
+            for (const auto &block_id : _get_block_list(inode))
+                ref_cnt[block_id]++;
         }
+        for (const auto &[block_id, cnt] : ref_cnt)
+            if (cnt > 1)
+                block_refs[block_id] = cnt;
+    }
 
-        return new_inode_id;
+    void _add_block_ref(const short &block_id)
+    {
+        int &refs = block_refs[block_id];
+        refs = max(refs, 1) + 1;
     }
 
-    // 传入文件路径和文件大小（KB），创建文件
-    void create_file(const string &path, const unsigned short &filesize_kb)
+    // 占用或释放 INode 尾部片段所在的槽位
+    void _mark_tail(const INode &inode, const bool used)
     {
-        // 将路径转为绝对路径
-        string absolute_path = _absolute_path(path);
+        const int size = Util::tail_size(inode.file_size);
+        const uint32_t mask = ((1u << ((size + TAIL_SLOT_SIZE - 1) / TAIL_SLOT_SIZE)) - 1) << (inode.tail_offset / TAIL_SLOT_SIZE);
+        TailBlock &tail_block = tail_blocks[inode.tail_block];
+        tail_block.slot_mask = used ? tail_block.slot_mask | mask : tail_block.slot_mask & ~mask;
+        tail_block.tail_num += used ? 1 : -1;
+        tail_block.byte_num += used ? size : -size;
+    }
 
-        dout << "[创建文件] 准备创建 " << absolute_path << "，文件大小为 " << filesize_kb << "KB" << endl;
+    // 汇总各分配组的空闲数，分配与释放时不再逐次写回超级块
+    int _available_block_num() const
+    {
+        int num = 0;
+        for (const auto &group : alloc_groups)
+            num += group.free_block_num;
+        return num;
+    }
 
-        // 根据路径查找 Inode
-        short dir_inode_id, file_inode_id;
-        _search_inode(path, dir_inode_id, file_inode_id);
+    int _available_inode_num() const
+    {
+        int num = 0;
+        for (const auto &group : alloc_groups)
+            num += group.free_inode_num;
+        return num;
+    }
 
-        if (dir_inode_id == -1)
-        {
-            // cout << "[创建文件] 路径 " << absolute_path << " 无效" << endl;
-            cout << "touch: cannot touch '" << absolute_path << "': No such file or directory" << endl;
-            return;
-        }
+    void _sync_superblock_counters()
+    {
+        superblock.available_block_num = _available_block_num();
+        superblock.available_inode_num = _available_inode_num();
+    }
 
-        // 如果 file_inode_id 不为 -1，则说明文件已存在
-        if (file_inode_id != -1)
+    // 当前线程的默认分配组，目标组的锁被其他线程占用时改在此组分配，使并行的创建操作分散到不同的组
+    static int _home_group()
+    {
+        static atomic<int> next_group{0};
+        thread_local const int home_group = next_group++ % GROUP_NUM;
+        return home_group;
+    }
+
+    // 选定本次分配的起始组：目标组空闲则直接使用，否则退回当前线程的默认组
+    int _pick_group(const int &goal_group, unique_lock<mutex> &group_lock)
+    {
+        group_lock = unique_lock<mutex>(alloc_groups[goal_group].lock, try_to_lock);
+        if (group_lock.owns_lock())
+            return goal_group;
+        group_lock = unique_lock<mutex>(alloc_groups[_home_group()].lock);
+        return _home_group();
+    }
+
+    static int _block_group(const short &block_id)
+    {
+        return block_id / BLOCKS_PER_GROUP;
+    }
+
+    static int _inode_group(const short &inode_id)
+    {
+        return inode_id / INODES_PER_GROUP;
+    }
+
+    // Orlov 策略为新目录选择分配组
+    int _find_dir_group(const short &parent_inode_id)
+    {
+        const int avg_free_inode_num = _available_inode_num() / GROUP_NUM;
+        const int avg_free_block_num = _available_block_num() / GROUP_NUM;
+
+        if (parent_inode_id == ROOT_INODE_ID)
         {
-            // cout << "[创建文件] 文件 " << absolute_path << " 已存在" << endl;
-            cout << "touch: cannot touch '" << absolute_path << "': File exists" << endl;
-            return;
+            // 顶层目录：在空闲 INode 与空闲块均不低于平均值的组中选目录数最少的组，使互不相关的子树彼此分散
+            int best_group = -1;
+            for (int g = 0; g < GROUP_NUM; g++)
+            {
+                const AllocGroup &group = alloc_groups[g];
+                if (group.free_inode_num == 0 || group.free_inode_num < avg_free_inode_num || group.free_block_num < avg_free_block_num)
+                    continue;
+                if (best_group == -1 || group.dir_num < alloc_groups[best_group].dir_num)
+                    best_group = g;
+            }
+            if (best_group != -1)
+                return best_group;
+        }
+        else
+        {
+            // 子目录：父目录所在组资源尚充足时留在本组，否则向后寻找资源充足的组
+            const int parent_group = _inode_group(parent_inode_id);
+            for (int k = 0; k < GROUP_NUM; k++)
+            {
+                const AllocGroup &group = alloc_groups[(parent_group + k) % GROUP_NUM];
+                if (group.free_inode_num > 0 && group.free_inode_num >= avg_free_inode_num / 2 && group.free_block_num >= avg_free_block_num / 2)
+                    return (parent_group + k) % GROUP_NUM;
+            }
         }
 
-        if (superblock.available_inode_num == 0)
+        // 各组都不满足条件时退化为空闲 INode 最多的组
+        int best_group = 0;
+        for (int g = 1; g < GROUP_NUM; g++)
+            if (alloc_groups[g].free_inode_num > alloc_groups[best_group].free_inode_num)
+                best_group = g;
+        return best_group;
+    }
+
+    // 获取可用块 ID 并在 bitmap 中标记已使用
+    // 优先在 goal_group 组内首次适配（组锁被占用时改用当前线程的默认组），该组已满时依次尝试后续各组
+    // 上次提交以来释放的块在提交前不复用：崩溃后重放会恢复释放前的文件，其块不能已被新数据覆盖（同 ext3）
+    // 空间检查会在这些块不够用时提前提交（见 _reserve_blocks），只有估算不足、其余空闲块均已用尽时才退而复用
+    short _get_avail_block(const int &goal_group = 0)
+    {
+        for (const bool reuse_freed : {false, true})
         {
-            // cout << "[创建文件] 可用 Inode 不足，文件创建失败！" << endl;
-            cout << "touch: cannot touch '" << absolute_path << "': No available inode" << endl;
-            return;
+            unique_lock<mutex> group_lock;
+            const int start_group = _pick_group(goal_group, group_lock);
+            for (int k = 0; k < GROUP_NUM; k++)
+            {
+                const int g = (start_group + k) % GROUP_NUM;
+                // 先释放当前组的锁再锁定下一组：移动赋值会先锁定新组再释放旧锁，同时持有两把组锁可能与其他线程形成环路
+                if (k > 0)
+                {
+                    group_lock.unlock();
+                    group_lock = unique_lock<mutex>(alloc_groups[g].lock);
+                }
+                if (alloc_groups[g].free_block_num == 0)
+                    continue;
+
+                const int end = min(DATA_BLOCK_NUM, (g + 1) * BLOCKS_PER_GROUP);
+                for (int i = g * BLOCKS_PER_GROUP; i < end; i++)
+                    if (!block_bitmap.get(i) && _claim_block(i, reuse_freed))
+                    {
+                        dout << "[可用块申请] 新申请：" << i << "（分配组 " << g << "）" << endl;
+                        // Bitmap（只写回改动的字节）
+                        block_bitmap.set(i);
+                        _dump(&block_bitmap.bitmap[i / 8], BLOCK_BITMAP_START + i / 8, 1);
+                        alloc_groups[g].free_block_num--;
+                        return i;
+                    }
+            }
         }
 
-        if (superblock.available_block_num < Util::block_occupation(filesize_kb))
+        dout << "[可用块申请] 无可用块" << endl;
+        return -1;
+    }
+
+    // 空闲块能否分配：上次提交以来释放的块只在 reuse_freed 时分配，并不再作为已释放的块打洞（调用前需持有其所在分配组的锁）
+    // 已提交的状态中仍被占用的块不记入 allocated_blocks，其数据经日志写入
+    bool _claim_block(const short &block_id, const bool &reuse_freed)
+    {
+        lock_guard<mutex> journal_lock(journal_mutex);
+        if (!freed_blocks.count(block_id))
         {
-            // cout << "[创建文件] 可用块不足，文件创建失败！创建大小为 " << filesize_kb << "KB 的文件需要 " << Util::block_occupation(filesize_kb) << " 个块，目前可用块剩余 " << superblock.available_block_num << " 个" << endl;
-            cout << "touch: cannot touch '" << absolute_path << "': No available block" << endl;
-            return;
+            allocated_blocks.insert(block_id);
+            return true;
         }
+        if (!reuse_freed)
+            return false;
+        dout << "[可用块申请] 其余空闲块均已用尽，复用上次提交以来释放的块 " << block_id << endl;
+        freed_blocks.erase(block_id);
+        return true;
+    }
 
-        short new_inode_id = _create_file(dir_inode_id, _filename(path), filesize_kb);
+    // 申请 block_num 个可用块追加到 block_id_list，全部申请到才返回 true；中途申请失败时释放本次已申请的块，block_id_list 保持不变
+    bool _get_avail_blocks(const int &block_num, const int &goal_group, vector<short> &block_id_list)
+    {
+        vector<short> new_block_id_list;
+        for (int i = 0; i < block_num; i++)
+        {
+            const short block_id = _get_avail_block(goal_group);
+            if (block_id == -1)
+            {
+                dout << "[可用块申请] 需要 " << block_num << " 个块，只申请到 " << i << " 个，全部退回" << endl;
+                _clear_block(new_block_id_list);
+                return false;
+            }
+            new_block_id_list.push_back(block_id);
+        }
+        block_id_list.insert(block_id_list.end(), new_block_id_list.begin(), new_block_id_list.end());
+        return true;
+    }
 
-        dout << "[创建文件] 新 Inode 信息：" << endl;
-        dout << _get_inode(new_inode_id) << endl;
+    // 确认有 block_num 个可分配的块；空闲块中上次提交以来释放的块不够用时，先提交此前关闭的事务使其可以复用
+    // 只在最外层事务尚未修改任何元数据时（各命令检查空间时）调用，此时提交不会拆开当前操作
+    bool _reserve_blocks(const int &block_num)
+    {
+        if (_available_block_num() < block_num)
+            return false;
+        lock_guard<mutex> journal_lock(journal_mutex);
+        if (_available_block_num() - (int)freed_blocks.size() < block_num && transaction_depth <= 1)
+        {
+            dout << "[可用块申请] 需要复用上次提交以来释放的 " << freed_blocks.size() << " 个块，先提交" << endl;
+            _journal_commit();
+            _punch_freed_blocks();
+        }
+        return true;
+    }
 
-        dout << "[创建文件] 文件 " << absolute_path << " 创建成功" << endl;
+    // 获取可用 inode ID 并在 bitmap 中标记已使用
+    // 优先在 goal_group 组内首次适配（组锁被占用时改用当前线程的默认组），该组已满时依次尝试后续各组
+    short _get_avail_inode(const int &goal_group = 0)
+    {
+        unique_lock<mutex> group_lock;
+        const int start_group = _pick_group(goal_group, group_lock);
+        for (int k = 0; k < GROUP_NUM; k++)
+        {
+            const int g = (start_group + k) % GROUP_NUM;
+            if (k > 0)
+            {
+                group_lock.unlock();
+                group_lock = unique_lock<mutex>(alloc_groups[g].lock);
+            }
+            if (alloc_groups[g].free_inode_num == 0)
+                continue;
+
+            for (int i = g * INODES_PER_GROUP; i < (g + 1) * INODES_PER_GROUP; i++)
+                if (!inode_bitmap.get(i))
+                {
+                    dout << "[可用 INode 申请] 新申请：" << i << "（分配组 " << g << "）" << endl;
+                    // Bitmap（只写回改动的字节）
+                    inode_bitmap.set(i);
+                    _dump(&inode_bitmap.bitmap[i / 8], INODE_BITMAP_START + i / 8, 1);
+                    alloc_groups[g].free_inode_num--;
+                    return i;
+                }
+        }
+
+        dout << "[可用 INode 申请] 无可用 INode" << endl;
+        return -1;
     }
 
-    const short _create_dir(const short &dir_inode_id, const string &new_dirname)
+    void _clear_block(short id)
     {
-        // 申请新可用 Inode 和 Block
-        short new_inode_id = _get_avail_inode();
-        dout << "[创建目录] 已申请新 Inode：" << new_inode_id << endl;
+        vector<short> block_id_list = {id};
+        _clear_block(block_id_list);
+    }
 
-        short new_block_id = _get_avail_block();
-        dout << "[创建目录] 已申请新 Block：" << new_block_id << endl;
+    // 按分配组批量释放，每组只加锁一次，并只写回该组内改动过的 bitmap 字节范围
+    // 共享的数据块只减少引用数，最后一个引用释放时才真正释放
+    void _clear_block(vector<short> &block_id_list)
+    {
+        vector<short> sorted_list;
+        for (const auto &block_id : block_id_list)
+        {
+            auto it = block_refs.find(block_id);
+            if (it == block_refs.end())
+                sorted_list.push_back(block_id);
+            else if (--it->second == 1)
+                block_refs.erase(it);
+        }
+        sort(sorted_list.begin(), sorted_list.end());
+        for (size_t k = 0; k < sorted_list.size();)
+        {
+            const int g = _block_group(sorted_list[k]);
+            lock_guard<mutex> group_lock(alloc_groups[g].lock);
+            const int first_byte = sorted_list[k] / 8;
+            int last_byte = first_byte;
+            const size_t group_begin = k;
+            for (; k < sorted_list.size() && _block_group(sorted_list[k]) == g; k++)
+            {
+                block_bitmap.set(sorted_list[k], 0);
+                alloc_groups[g].free_block_num++;
+                last_byte = sorted_list[k] / 8;
+            }
+            _dump(&block_bitmap.bitmap[first_byte], BLOCK_BITMAP_START + first_byte, last_byte - first_byte + 1);
+            // 释放后即在组锁内登记，其他线程在提交前不会分配到这些块
+            lock_guard<mutex> journal_lock(journal_mutex);
+            freed_blocks.insert(sorted_list.begin() + group_begin, sorted_list.begin() + k);
+        }
+    }
 
-        // 初始化 Inode
-        _save_inode(new_inode_id, 'd', BLOCK_SIZE);
+    void _clear_inode(short id)
+    {
+        const int g = _inode_group(id);
+        lock_guard<mutex> group_lock(alloc_groups[g].lock);
+        inode_bitmap.set(id, 0);
+        alloc_groups[g].free_inode_num++;
+        _dump(&inode_bitmap.bitmap[id / 8], INODE_BITMAP_START + id / 8, 1);
+    }
 
-        // 初始化 Dentry 数据块
-        _create_blank_dentries(new_block_id, new_inode_id, dir_inode_id);
+    // 目录 d 的数据块
+    void _create_blank_dentries(const short &block_id, const short &curr_dir_inode_id, const short &parent_dir_inode_id)
+    {
+        // dout << "[创建空 Dentry 数据块] Block ID: " << block_id << "，当前目录 INode ID: " << curr_dir_inode_id << "，父目录 INode ID: " << parent_dir_inode_id << endl;
 
-        // 向新文件所在的目录添加目录项
-        _add_dentry(dir_inode_id, new_inode_id, new_dirname);
+        vector<Dentry> dentry(DENTRY_NUM_PER_BLOCK);
 
-        return new_inode_id;
+        dentry[0] = Dentry(curr_dir_inode_id, ".", 'd');
+        INode curr_dir_inode = _get_inode(curr_dir_inode_id);
+        curr_dir_inode.direct_block[0] = block_id;
+        curr_dir_inode.subtree_block_cnt++;
+        curr_dir_inode.dentry_cnt = 2;
+        curr_dir_inode.free_block_hint = 0;
+        curr_dir_inode.link_cnt++;
+        _save_inode(curr_dir_inode);
+        // dout << "[创建空 Dentry 数据块] Curr Dir INode ID：" << curr_dir_inode_id << endl
+        //      << curr_dir_inode << endl;
+        // dout << "[创建空 Dentry 数据块] INode 0：" << endl
+        //      << _get_inode(0) << endl;
+
+        dentry[1] = Dentry(parent_dir_inode_id, "..", 'd');
+        INode parent_dir_inode = _get_inode(parent_dir_inode_id);
+        parent_dir_inode.link_cnt++;
+        _save_inode(parent_dir_inode);
+        // dout << "[创建空 Dentry 数据块] Parent Dir INode ID：" << parent_dir_inode_id << endl
+        //      << parent_dir_inode << endl;
+        // dout << "[创建空 Dentry 数据块] INode 0：" << endl
+        //      << _get_inode(0) << endl;
+
+        _dump(dentry.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
     }
 
-    void create_dir(const string path, bool parent = false)
+    // inode 的间接地址数据块
+    void _create_blank_address_block(short block_id)
     {
-        // 将路径转为绝对路径
-        string absolute_path = _absolute_path(path);
+        short *block = new short[ADDRESS_PER_BLOCK];
+        fill_n(block, ADDRESS_PER_BLOCK, -1);
+        _dump(block, BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+        delete[] block;
+    }
 
-        dout << "[创建目录] 准备创建 " << absolute_path << " ..." << endl;
+    // 由块ID向量生成直接块ID、间接块ID、双重间接块ID
+    // 确保文件大小不超过最大值才执行以下函数
+    void _set_block_list(INode &inode, const vector<short> &block_id_list)
+    {
+        TRACE_SCOPE("_set_block_list");
+        // 清空 INode 地址
+        inode.clear_address();
 
-        if (superblock.available_inode_num == 0)
-        {
-            // cout << "[创建目录] 可用 Inode 不足，目录创建失败！" << endl;
-            cout << "mkdir: cannot create directory '" << absolute_path << "': No available inode" << endl;
-            return;
-        }
+        dout << "[写入 INode 块地址] 共有 " << block_id_list.size() << " 个数据块" << endl;
+        int addr_block_cnt = _append_block_list(inode, 0, block_id_list);
 
-        if (superblock.available_block_num == 0)
-        {
-            dout << "[创建目录] 可用块不足，目录创建失败！此时的超级块信息：" << endl;
-            dout << superblock;
-            // cout << "[创建目录] 可用块不足，目录创建失败！" << endl;
-            cout << "mkdir: cannot create directory '" << absolute_path << "': No available block" << endl;
-            return;
-        }
+        // 文件的子树块数即其数据块与地址块之和
+        inode.subtree_block_cnt = block_id_list.size() + addr_block_cnt;
+        _save_inode(inode);
+    }
 
-        // 根据路径查找 Inode
-        short dir_inode_id, file_inode_id;
-        _search_inode(path, dir_inode_id, file_inode_id);
+    // 将数据块追加到 INode 的第 start 个逻辑块之后，只改写涉及到的地址块，已有的间接地址块直接复用
+    // 不保存 INode，返回新申请的地址块数（确保追加后不超过最大文件大小才执行）
+    int _append_block_list(INode &inode, const int &start, const vector<short> &block_id_list)
+    {
+        TRACE_SCOPE("_append_block_list");
+        const int indirect_start = NUM_DIRECT_BLOCK;
+        const int double_indirect_start = NUM_DIRECT_BLOCK + NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK;
 
-        // 如果 file_inode_id 不为 -1，则说明文件已存在
-        if (file_inode_id != -1)
-        {
-            // cout << "[创建目录] " << absolute_path << " 已存在" << endl;
-            cout << "mkdir: cannot create directory '" << absolute_path << "': File exists" << endl;
-            return;
-        }
+        int addr_block_cnt = 0;
+        int idx = start;
+        size_t k = 0;
 
-        short new_inode_id;
-        if (!parent)
+        // 直接块
+        while (k < block_id_list.size() && idx < indirect_start)
+            inode.direct_block[idx++] = block_id_list[k++];
+
+        // 间接块
+        if (k < block_id_list.size() && idx < double_indirect_start)
         {
-            if (dir_inode_id == -1)
+            vector<short> addr(ADDRESS_PER_BLOCK, -1);
+            if (inode.indirect_block[0] == -1)
             {
-                // cout << "[创建目录] 路径 " << absolute_path << " 无效" << endl;
-                cout << "mkdir: cannot create directory '" << absolute_path << "': No such file or directory" << endl;
-                return;
+                inode.indirect_block[0] = _get_avail_block(_inode_group(inode.id));
+                addr_block_cnt++;
             }
+            else
+                _load(addr.data(), BLOCK_START + inode.indirect_block[0] * BLOCK_SIZE, BLOCK_SIZE);
 
-            new_inode_id = _create_dir(dir_inode_id, _filename(path));
+            while (k < block_id_list.size() && idx < double_indirect_start)
+                addr[idx++ - indirect_start] = block_id_list[k++];
+            _dump(addr.data(), BLOCK_START + inode.indirect_block[0] * BLOCK_SIZE, BLOCK_SIZE);
         }
 
-        else if (parent)
+        // 二级间接块
+        if (k < block_id_list.size())
         {
-            vector<string> dir_vector = _split_path(absolute_path);
-            short _dir_inode_id = ROOT_INODE_ID;
-            short _ptr_inode_id;
-            for (const auto &level : dir_vector)
+            vector<short> _1st_address_block(ADDRESS_PER_BLOCK, -1); // 二级地址块的地址
+            if (inode.double_indirect_block[0] == -1)
             {
-                _ptr_inode_id = _search_inode(_dir_inode_id, level);
+                inode.double_indirect_block[0] = _get_avail_block(_inode_group(inode.id));
+                addr_block_cnt++;
+            }
+            else
+                _load(_1st_address_block.data(), BLOCK_START + inode.double_indirect_block[0] * BLOCK_SIZE, BLOCK_SIZE);
 
-                if (_ptr_inode_id == -1)
-                    _ptr_inode_id = _create_dir(_dir_inode_id, level);
+            while (k < block_id_list.size())
+            {
+                const int i = (idx - double_indirect_start) / ADDRESS_PER_BLOCK;
+                vector<short> block(ADDRESS_PER_BLOCK, -1);
+                if (_1st_address_block[i] == -1)
+                {
+                    _1st_address_block[i] = _get_avail_block(_inode_group(inode.id));
+                    addr_block_cnt++;
+                    dout << "[追加 INode 块地址] 新增二级间接块 " << i << "：" << _1st_address_block[i] << endl;
+                }
+                else
+                    _load(block.data(), BLOCK_START + _1st_address_block[i] * BLOCK_SIZE, BLOCK_SIZE);
 
-                _dir_inode_id = _ptr_inode_id;
+                while (k < block_id_list.size() && (idx - double_indirect_start) / ADDRESS_PER_BLOCK == i)
+                    block[(idx++ - double_indirect_start) % ADDRESS_PER_BLOCK] = block_id_list[k++];
+                _dump(block.data(), BLOCK_START + _1st_address_block[i] * BLOCK_SIZE, BLOCK_SIZE);
             }
-            new_inode_id = _ptr_inode_id;
+            _dump(_1st_address_block.data(), BLOCK_START + inode.double_indirect_block[0] * BLOCK_SIZE, BLOCK_SIZE);
         }
 
-        dout << "[创建目录] 新 Inode 信息：" << endl;
-        dout << _get_inode(new_inode_id) << endl;
-
-        dout << "[创建目录] 目录 " << absolute_path << " 创建成功" << endl;
+        return addr_block_cnt;
     }
 
-    void _remove(const short &dir_inode_id, const short &file_inode_id)
+    // 释放 INode 第 new_block_num 个逻辑块及之后的全部数据块，变空的地址块一并释放
+    // 不保存 INode，返回释放的块总数（数据块 + 地址块）
+    int _truncate_block_list(INode &inode, const int &old_block_num, const int &new_block_num)
     {
-        // 删除特定文件
-        if (file_inode_id > 0)
-        {
-            INode file_inode = _get_inode(file_inode_id);
-            dout << "[删除文件] 正在删除如下文件：" << endl;
-            dout << file_inode;
+        TRACE_SCOPE("_truncate_block_list");
+        const int indirect_start = NUM_DIRECT_BLOCK;
+        const int double_indirect_start = NUM_DIRECT_BLOCK + NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK;
 
-            // 删除该文件对应的目录项
-            _remove_dentry(dir_inode_id, file_inode_id);
+        vector<short> freed_block_list;
 
-            // 如果文件自身硬链接数降为 0，则彻底删除文件
-            if (_get_inode(file_inode_id).link_cnt == 0)
+        // 二级间接块
+        if (old_block_num > double_indirect_start && inode.double_indirect_block[0] != -1)
+        {
+            vector<short> _1st_address_block(ADDRESS_PER_BLOCK, -1);
+            _load(_1st_address_block.data(), BLOCK_START + inode.double_indirect_block[0] * BLOCK_SIZE, BLOCK_SIZE);
+
+            const int first = max(new_block_num, double_indirect_start) - double_indirect_start;
+            const int last = old_block_num - double_indirect_start; // 不含
+            for (int i = first / ADDRESS_PER_BLOCK; i <= (last - 1) / ADDRESS_PER_BLOCK; i++)
             {
-                dout << "[删除文件] 文件硬链接数此时为 0，彻底删除文件 ..." << endl;
+                if (_1st_address_block[i] == -1)
+                    continue;
 
-                // 释放文件的数据块
-                vector<short> block_id_list = _get_block_list(file_inode);
-                dout << "[删除文件] 删除该文件的数据块：" << block_id_list << endl;
-                _clear_block(block_id_list);
+                vector<short> block(ADDRESS_PER_BLOCK, -1);
+                _load(block.data(), BLOCK_START + _1st_address_block[i] * BLOCK_SIZE, BLOCK_SIZE);
+                for (int j = max(first - i * ADDRESS_PER_BLOCK, 0); j < min(last - i * ADDRESS_PER_BLOCK, ADDRESS_PER_BLOCK); j++)
+                    if (block[j] != -1)
+                    {
+                        freed_block_list.push_back(block[j]);
+                        block[j] = -1;
+                    }
 
-                // 释放文件的间接地址块
-                vector<short> addr_block_list = _get_addr_block_list(file_inode);
-                dout << "[删除文件] 删除该文件的地址块：" << addr_block_list << endl;
-                _clear_block(addr_block_list);
+                // 第二级地址块已无地址则释放，否则写回
+                if (first <= i * ADDRESS_PER_BLOCK)
+                {
+                    freed_block_list.push_back(_1st_address_block[i]);
+                    _1st_address_block[i] = -1;
+                }
+                else
+                    _dump(block.data(), BLOCK_START + _1st_address_block[i] * BLOCK_SIZE, BLOCK_SIZE);
+            }
 
-                // 释放文件的 INode
-                dout << "[删除文件] 删除文件的 INode" << endl;
-                _clear_inode(file_inode_id);
+            if (first == 0)
+            {
+                freed_block_list.push_back(inode.double_indirect_block[0]);
+                inode.double_indirect_block[0] = -1;
             }
-            return;
+            else
+                _dump(_1st_address_block.data(), BLOCK_START + inode.double_indirect_block[0] * BLOCK_SIZE, BLOCK_SIZE);
         }
 
-        else if (file_inode_id == -1)
-        // 删除整个文件夹
+        // 间接块
+        if (old_block_num > indirect_start && new_block_num < double_indirect_start && inode.indirect_block[0] != -1)
         {
-            // 列出所有目录项
-            vector<Dentry> dentry_list = _load_dentries(dir_inode_id);
-            for (const auto &dentry : dentry_list)
-                if (dentry.inode_id != -1 && dentry.get_filename() != "." && dentry.get_filename() != "..")
+            vector<short> addr(ADDRESS_PER_BLOCK, -1);
+            _load(addr.data(), BLOCK_START + inode.indirect_block[0] * BLOCK_SIZE, BLOCK_SIZE);
+            for (int j = max(new_block_num, indirect_start); j < min(old_block_num, double_indirect_start); j++)
+                if (addr[j - indirect_start] != -1)
                 {
-                    INode _inode = _get_inode(dentry.inode_id);
-                    // 如果是文件
-                    if (_inode.file_type == 'f')
-                        _remove(dir_inode_id, dentry.inode_id);
-                    // 如果是文件夹
-                    if (_inode.file_type == 'd')
-                        _remove(dentry.inode_id, -1);
+                    freed_block_list.push_back(addr[j - indirect_start]);
+                    addr[j - indirect_start] = -1;
                 }
 
-            // 此时已经是目录下为空
-            dentry_list = _load_dentries(dir_inode_id);
-            dout << "目录下的所有文件/文件夹已被递归删除，此时目录项为：" << endl;
-            dout << dentry_list;
-
-            // 删除该目录在其父目录中的目录项
-            dout << "[删除目录] 删除该目录在其父目录中的目录项 ..." << endl;
-            short parent_dir_inode_id = dentry_list[1].inode_id;
-            _remove_dentry(parent_dir_inode_id, dir_inode_id);
-
-            // 释放目录的数据块
-            vector<short> block_id_list = _get_block_list(dir_inode_id);
-            dout << "[删除目录] 删除该目录的数据块：" << block_id_list << endl;
-            _clear_block(block_id_list);
+            if (new_block_num <= indirect_start)
+            {
+                freed_block_list.push_back(inode.indirect_block[0]);
+                inode.indirect_block[0] = -1;
+            }
+            else
+                _dump(addr.data(), BLOCK_START + inode.indirect_block[0] * BLOCK_SIZE, BLOCK_SIZE);
+        }
 
-            // 释放目录的间接地址块
-            vector<short> addr_block_list = _get_addr_block_list(dir_inode_id);
-            dout << "[删除目录] 删除该目录的地址块：" << addr_block_list << endl;
-            _clear_block(addr_block_list);
+        // 直接块
+        for (int i = new_block_num; i < min(old_block_num, indirect_start); i++)
+            if (inode.direct_block[i] != -1)
+            {
+                freed_block_list.push_back(inode.direct_block[i]);
+                inode.direct_block[i] = -1;
+            }
 
-            // 释放目录的 INode
-            dout << "[删除目录] 删除目录的 INode" << endl;
-            _clear_inode(dir_inode_id);
-        }
+        dout << "[截断 INode 块地址] 释放的块：" << freed_block_list << endl;
+        _clear_block(freed_block_list);
+        return freed_block_list.size();
     }
 
-    void remove(const string &path, bool recursive = false)
+    void _set_block_list(const short &inode_id, const vector<short> &block_id_list)
     {
-        // 将路径转为绝对路径
-        string absolute_path = _absolute_path(path);
+        INode inode = _get_inode(inode_id);
+        assert(inode.id == inode_id);
+        _set_block_list(inode, block_id_list);
+    }
 
-        dout << "[删除文件/目录] 准备删除 " << absolute_path << " ..." << endl;
+    // 由逻辑块号获取数据块 ID，只读取路径上的地址项（至多两次），不存在时返回 -1
+    short _get_block_id(const INode &inode, int idx)
+    {
+        if (idx < NUM_DIRECT_BLOCK)
+            return inode.direct_block[idx];
 
-        if (absolute_path == "/")
+        short block_id = -1;
+        idx -= NUM_DIRECT_BLOCK;
+        if (idx < NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK)
         {
-            // cout << "[删除文件/目录] 根目录不可删除" << endl;
-            cout << "rm: cannot remove root directory" << endl;
+            if (inode.indirect_block[0] != -1)
+                _load(&block_id, BLOCK_START + inode.indirect_block[0] * BLOCK_SIZE + idx * ADDRESS_SIZE, ADDRESS_SIZE);
+            return block_id;
+        }
+
+        idx -= NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK;
+        if (inode.double_indirect_block[0] == -1)
+            return -1;
+        short _2nd_address_block_id = -1;
+        _load(&_2nd_address_block_id, BLOCK_START + inode.double_indirect_block[0] * BLOCK_SIZE + idx / ADDRESS_PER_BLOCK * ADDRESS_SIZE, ADDRESS_SIZE);
+        if (_2nd_address_block_id != -1)
+            _load(&block_id, BLOCK_START + _2nd_address_block_id * BLOCK_SIZE + idx % ADDRESS_PER_BLOCK * ADDRESS_SIZE, ADDRESS_SIZE);
+        return block_id;
+    }
+
+    // 修改逻辑块 idx 对应的数据块 ID（该逻辑块须已存在），直接块只改 INode，调用方负责保存
+    void _set_block_id(INode &inode, int idx, const short &block_id)
+    {
+        if (idx < NUM_DIRECT_BLOCK)
+        {
+            inode.direct_block[idx] = block_id;
+            return;
+        }
+
+        idx -= NUM_DIRECT_BLOCK;
+        if (idx < NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK)
+        {
+            _dump(&block_id, BLOCK_START + inode.indirect_block[0] * BLOCK_SIZE + idx * ADDRESS_SIZE, ADDRESS_SIZE);
+            return;
+        }
+
+        idx -= NUM_INDIRECT_BLOCK * ADDRESS_PER_BLOCK;
+        short _2nd_address_block_id = -1;
+        _load(&_2nd_address_block_id, BLOCK_START + inode.double_indirect_block[0] * BLOCK_SIZE + idx / ADDRESS_PER_BLOCK * ADDRESS_SIZE, ADDRESS_SIZE);
+        _dump(&block_id, BLOCK_START + _2nd_address_block_id * BLOCK_SIZE + idx % ADDRESS_PER_BLOCK * ADDRESS_SIZE, ADDRESS_SIZE);
+    }
+
+    // 由 inode 的直接块ID、间接块ID、双重间接块ID获取其块ID向量
+    // 返回块 ID 向量，根据这个向量就能获取所有内容
+    vector<short> _get_block_list(const INode &inode)
+    {
+        TRACE_SCOPE("_get_block_list");
+        vector<short> block_id_list;
+
+        // 直接块
+        for (int i = 0; i < NUM_DIRECT_BLOCK; i++)
+            if (inode.direct_block[i] != -1)
+            {
+                // dout << "[读取 INode 块列表] 直接块 " << i << " ：" << inode.direct_block[i] << endl;
+                block_id_list.push_back(inode.direct_block[i]);
+            }
+
+        // 间接块
+        for (int i = 0; i < NUM_INDIRECT_BLOCK; i++)
+            if (inode.indirect_block[i] != -1)
+            {
+                // dout << "[读取 INode 块列表] 间接块 " << i << " ：" << inode.indirect_block[i] << endl;
+                vector<short> block(ADDRESS_PER_BLOCK, -1);
+                _load(block.data(), BLOCK_START + inode.indirect_block[i] * BLOCK_SIZE, BLOCK_SIZE);
+                for (int j = 0; j < ADDRESS_PER_BLOCK; j++)
+                    if (block[j] != -1)
+                    {
+                        // dout << "[读取 INode 块列表] 间接块 " << i << " ，地址 " << j << " ：" << block[j] << endl;
+                        block_id_list.push_back(block[j]);
+                    }
+            }
+
+        // 二级间接块
+        for (int i = 0; i < NUM_DOUBLE_INDIRECT_BLOCK; i++)
+            if (inode.double_indirect_block[i] != -1)
+            {
+                // dout << "[读取 INode 块列表] 双重间接块 " << i << " ：" << inode.double_indirect_block[i] << endl;
+                vector<short> block(ADDRESS_PER_BLOCK, -1);
+                _load(block.data(), BLOCK_START + inode.double_indirect_block[i] * BLOCK_SIZE, BLOCK_SIZE);
+                for (int j = 0; j < ADDRESS_PER_BLOCK; j++)
+                    if (block[j] != -1)
+                    {
+                        // dout << "[读取 INode 块列表] 双重间接块 " << i << " ，地址 " << j << " ：" << block[j] << endl;
+                        vector<short> block2(ADDRESS_PER_BLOCK, -1);
+                        _load(block2.data(), BLOCK_START + block[j] * BLOCK_SIZE, BLOCK_SIZE);
+                        for (int k = 0; k < ADDRESS_PER_BLOCK; k++)
+                            if (block2[k] != -1)
+                                block_id_list.push_back(block2[k]);
+                    }
+            }
+
+        return block_id_list;
+    }
+
+    vector<short> _get_block_list(const short &inode_id)
+    {
+        INode inode = _get_inode(inode_id);
+        return _get_block_list(inode);
+    }
+
+    // 只存放间接地址块，有别于数据块
+    vector<short> _get_addr_block_list(const INode &inode)
+    {
+        vector<short> indirect_block_list;
+
+        // 间接块
+        for (int i = 0; i < NUM_INDIRECT_BLOCK; i++)
+            if (inode.indirect_block[i] != -1)
+                indirect_block_list.push_back(inode.indirect_block[i]);
+
+        // 二级间接块
+        for (int i = 0; i < NUM_DOUBLE_INDIRECT_BLOCK; i++)
+            if (inode.double_indirect_block[i] != -1)
+            {
+                // 将二级中的第一级间接块加入列表
+                indirect_block_list.push_back(inode.double_indirect_block[i]);
+
+                // 读取二级间接块
+                vector<short> addresses(ADDRESS_PER_BLOCK, -1);
+                _load(addresses.data(), BLOCK_START + inode.double_indirect_block[i] * BLOCK_SIZE, BLOCK_SIZE);
+                dout << "[获取间接地址块列表] 二级间接块第一级所有地址：" << addresses << endl;
+                for (const auto &address : addresses)
+                    if (address != -1)
+                        // 将二级中的第二级数据块加入列表
+                        indirect_block_list.push_back(address);
+            }
+
+        dout << "[获取间接地址块列表] 间接地址块列表大小：" << indirect_block_list.size() << endl;
+        dout << "[获取间接地址块列表] 间接地址块列表：" << indirect_block_list << endl;
+
+        return indirect_block_list;
+    }
+
+    vector<short> _get_addr_block_list(const short &inode_id)
+    {
+        INode inode = _get_inode(inode_id);
+        return _get_addr_block_list(inode);
+    }
+
+    // 读取目录第一个 Dentry 数据块中的 .. 目录项，得到父目录 INode ID
+    short _get_parent_inode_id(const INode &dir_inode)
+    {
+        vector<Dentry> dentry_list(DENTRY_NUM_PER_BLOCK);
+        _load(dentry_list.data(), BLOCK_START + dir_inode.direct_block[0] * BLOCK_SIZE, BLOCK_SIZE);
+        return dentry_list[1].inode_id;
+    }
+
+    // 将子树用量的变化累加到 dir_inode 及其所有祖先目录（dir_inode 会被同步更新并保存）
+    // 用量按目录项计算：同一文件的多个硬链接会在各自所在的目录链上分别计入
+    void _update_subtree_usage(INode &dir_inode, const int &inode_delta, const int &block_delta)
+    {
+        if (inode_delta == 0 && block_delta == 0)
+            return;
+
+        dir_inode.subtree_inode_cnt += inode_delta;
+        dir_inode.subtree_block_cnt += block_delta;
+        _save_inode(dir_inode);
+
+        INode ptr_inode = dir_inode;
+        while (ptr_inode.id != ROOT_INODE_ID)
+        {
+            ptr_inode = _get_inode(_get_parent_inode_id(ptr_inode));
+            ptr_inode.subtree_inode_cnt += inode_delta;
+            ptr_inode.subtree_block_cnt += block_delta;
+            _save_inode(ptr_inode);
+        }
+    }
+
+    void _update_subtree_usage(const short &dir_inode_id, const int &inode_delta, const int &block_delta)
+    {
+        INode dir_inode = _get_inode(dir_inode_id);
+        _update_subtree_usage(dir_inode, inode_delta, block_delta);
+    }
+
+    // 由根目录遍历目录树，记录每个文件的目录项所在的目录
+    void _build_link_dirs()
+    {
+        TRACE_SCOPE("_build_link_dirs");
+        link_dirs.clear();
+        vector<short> pending_dirs = {ROOT_INODE_ID};
+        while (!pending_dirs.empty())
+        {
+            const short dir_id = pending_dirs.back();
+            pending_dirs.pop_back();
+            for (const auto &dentry : _load_dentries(dir_id))
+            {
+                if (!strcmp(dentry.filename, ".") || !strcmp(dentry.filename, ".."))
+                    continue;
+                if (dentry.file_type == 'f')
+                    link_dirs[dentry.inode_id].push_back(dir_id);
+                else if (dentry.file_type == 'd')
+                    pending_dirs.push_back(dentry.inode_id);
+            }
+        }
+        link_dirs_ready = true;
+        dout << "[硬链接索引] 已记录 " << link_dirs.size() << " 个文件的目录项所在的目录" << endl;
+    }
+
+    // 文件新增或删除一个位于 dir_inode_id 中的目录项（尚未构建时无需维护）
+    void _track_link(const short &inode_id, const short &dir_inode_id, const bool added)
+    {
+        if (!link_dirs_ready)
+            return;
+        vector<short> &dirs = link_dirs[inode_id];
+        if (added)
+            dirs.push_back(dir_inode_id);
+        else
+        {
+            auto it = find(dirs.begin(), dirs.end(), dir_inode_id);
+            if (it != dirs.end())
+                dirs.erase(it);
+        }
+        if (dirs.empty())
+            link_dirs.erase(inode_id);
+    }
+
+    // 文件自身的块数变化后更新所有指向它的目录项所在的目录链；只有一个链接时即为本次路径所在的 dir_inode_id
+    // 多个链接所在的目录由 link_dirs 给出，只更新这些目录链，不再遍历目录树
+    void _update_file_usage(const short &dir_inode_id, const INode &inode, const int &block_delta)
+    {
+        if (block_delta == 0)
+            return;
+        if (inode.link_cnt <= 1)
+        {
+            _update_subtree_usage(dir_inode_id, 0, block_delta);
             return;
         }
+        if (!link_dirs_ready)
+            _build_link_dirs();
+        for (const auto &link_dir_id : link_dirs[inode.id])
+            _update_subtree_usage(link_dir_id, 0, block_delta);
+    }
+
+    string _absolute_path(const string path)
+    {
+        dout << "[获取绝对路径] 原始路径：" << path << endl;
+
+        if (path.empty())
+        {
+            dout << "[获取绝对路径] 路径为当前工作目录：" << working_dir << endl;
+            return working_dir;
+        }
+
+        // 如果是绝对路径，直接返回
+        if (path[0] == '/')
+        {
+            dout << "[获取绝对路径] " << path << " 为绝对路径" << endl;
+            return path;
+        }
+
+        // 如果 working_dir 末尾没有 '/'，则添加一个
+        string absolute_path = working_dir;
+        if (working_dir.back() != '/')
+            absolute_path += "/";
+
+        // 拼接当前工作目录
+        absolute_path += path;
+
+        // 若 absolute_path 末尾为 /.，则去掉
+        if (absolute_path.length() >= 2 && absolute_path.substr(absolute_path.length() - 2) == "/.")
+            absolute_path = absolute_path.substr(0, absolute_path.length() - 2);
+
+        // 若中间有 /./，则去掉
+        size_t pos = absolute_path.find("/./");
+        while (pos != string::npos)
+        {
+            absolute_path = absolute_path.substr(0, pos) + absolute_path.substr(pos + 2);
+            pos = absolute_path.find("/./");
+        }
+
+        // 若 absolute_path 末尾为 /..
+        regex double_dot_pattern("/\\.\\.(/|$)");
+        regex double_dot_valid_pattern("(/[^/]+?/\\.\\.)(/|$)");
+        smatch double_dot_match, double_dot_valid_match;
+        dout << "[获取绝对路径] 双点正则匹配结果：" << regex_search(absolute_path, double_dot_match, double_dot_pattern) << endl;
+        // 若 absolute_path 含有 ..
+        if (regex_search(absolute_path, double_dot_match, double_dot_pattern))
+        {
+            // 若 absolute_path 中的 .. 符合规范
+            if (regex_search(absolute_path, double_dot_valid_match, double_dot_valid_pattern))
+            {
+                dout << "[获取绝对路径] double_dot_valid_match.size(): " << double_dot_valid_match.size() << endl;
+                for (int i = 0; i < double_dot_valid_match.size(); i++)
+                    dout << "[获取绝对路径] double_dot_valid_match[" << i << "]: " << double_dot_valid_match[i] << endl;
+                dout << "[获取绝对路径] double_dot_valid_match.prefix(): " << double_dot_valid_match.prefix() << endl;
+                dout << "[获取绝对路径] double_dot_valid_match.suffix(): " << double_dot_valid_match.suffix() << endl;
+                dout << "[获取绝对路径] double_dot_valid_match.str(): " << double_dot_valid_match.str() << endl;
+                dout << "[获取绝对路径] double_dot_valid_match.position(): " << double_dot_valid_match.position() << endl;
+
+                // 将 absolute_path 中 double_dot_valid_match[1] 的部分替换为空
+                absolute_path = regex_replace(absolute_path, double_dot_valid_pattern, "/");
+            }
+            else
+            {
+                dout << "[获取绝对路径] 路径" << absolute_path << " 不合法，返回空字符串" << endl;
+                return "";
+            }
+        }
+
+        if (absolute_path == "/..")
+            return "/";
+
+        // 若 absolute_path 末尾为 / ，则去掉
+        if (absolute_path.back() == '/')
+            absolute_path = absolute_path.substr(0, absolute_path.length() - 1);
+
+        // 若 absolute_path 为空，则返回 /
+        if (absolute_path.empty())
+            return "/";
+
+        return absolute_path;
+    }
+
+    // 将路径分割为路径向量
+    vector<string> _split_path(const string path)
+    {
+        dout << "[路径分割] 原始路径：" << path << endl;
+        string absolute_path = _absolute_path(path);
+        dout << "[路径分割] 绝对路径：" << absolute_path << endl;
+
+        // 分割路径
+        istringstream iss(absolute_path);
+        vector<string> dir_vector;
+        string token;
+        while (getline(iss, token, '/'))
+            if (!token.empty())
+                dir_vector.push_back(token);
+
+        dout << "[路径分割] dir_vector: [";
+        for (const auto &level : dir_vector)
+            dout << level << " ";
+        dout << "]" << endl;
+
+        // 形式非法的路径将返回空值
+        return dir_vector;
+    }
+
+    // 用目录现有的目录项构建 Bloom 过滤器，预留一倍容量供后续新增
+    BloomFilter &_build_dentry_filter(const INode &dir_inode, const vector<Dentry> &dentry_list)
+    {
+        BloomFilter &filter = dentry_filters[dir_inode.id] = BloomFilter(max<int>(dentry_list.size(), dir_inode.dentry_cnt) * 2);
+        for (const auto &dentry : dentry_list)
+            filter.insert(dentry.get_filename());
+        dout << "[目录项过滤器] 为目录 INode " << dir_inode.id << " 构建过滤器，目录项 " << dentry_list.size() << " 个，容量 " << filter.capacity << endl;
+        return filter;
+    }
+
+    // 获取目录的 Bloom 过滤器，小目录不使用过滤器（返回空指针），过滤器不存在或已饱和时重建
+    const BloomFilter *_get_dentry_filter(const INode &dir_inode)
+    {
+        if (dir_inode.file_size / BLOCK_SIZE < BLOOM_MIN_BLOCK_NUM)
+            return nullptr;
+
+        auto it = dentry_filters.find(dir_inode.id);
+        if (it != dentry_filters.end() && dir_inode.dentry_cnt <= it->second.capacity)
+            return &it->second;
+
+        return &_build_dentry_filter(dir_inode, _load_dentries(dir_inode));
+    }
+
+    // 在目录中按名称查找目录项，找到即返回
+    // 大目录先查询 Bloom 过滤器，确定不存在时不读取任何 Dentry 块
+    bool _lookup_dentry(const short &dir_inode_id, const string &filename, Dentry &result)
+    {
+        TRACE_SCOPE("_lookup_dentry");
+        const INode dir_inode = _get_inode(dir_inode_id);
+        if (dir_inode.file_type != 'd')
+            return false;
+
+        const BloomFilter *filter = _get_dentry_filter(dir_inode);
+        if (filter && !filter->may_contain(filename))
+        {
+            dout << "[查找目录项] 过滤器确定目录 INode " << dir_inode_id << " 中不存在 " << filename << endl;
+            return false;
+        }
+
+        vector<short> block_id_list = _get_block_list(dir_inode);
+        vector<Dentry> dentry_list(DENTRY_NUM_PER_BLOCK);
+        for (const auto &block_id : block_id_list)
+        {
+            _load(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+            for (const auto &dentry : dentry_list)
+                if (dentry.inode_id != -1 && dentry.filename == filename)
+                {
+                    result = dentry;
+                    return true;
+                }
+        }
+        return false;
+    }
+
+    short _search_inode(const short &dir_inode_id, const string &filename)
+    {
+        TRACE_SCOPE("_search_inode");
+        dout << "[查找 Inode] 正在如下 INode 中查找目录项 " << filename << " ..." << endl;
+        dout << _get_inode(dir_inode_id);
+
+        Dentry dentry;
+        if (_lookup_dentry(dir_inode_id, filename, dentry))
+        {
+            dout << "[查找 Inode] 找到目录项 " << filename << "（inode_id: " << dentry.inode_id << "）" << endl;
+            return dentry.inode_id;
+        }
+
+        return -1;
+    }
+
+    void _search_inode(const string path, short &dir_inode_id, short &file_inode_id)
+    {
+        TRACE_SCOPE("_search_inode");
+        dout << "[查找 Inode] 根据路径 " << path << " 查找 Inode ..." << endl;
+
+        // 将路径转为路径向量
+        vector<string> dir_vector = _split_path(path);
+
+        dir_inode_id = -1;
+        file_inode_id = -1;
+
+        short ptr_inode_id = ROOT_INODE_ID;
+        char ptr_file_type = 'd';
+
+        if (dir_vector.empty())
+        {
+            dout << "[查找 Inode] 路径为空，返回根目录 Inode ID：" << ptr_inode_id << endl;
+            dir_inode_id = ptr_inode_id;
+            file_inode_id = ptr_inode_id;
+        }
+
+        else
+            for (const auto &level : dir_vector)
+            {
+                // 获取当前目录级别的数据块
+                // dout << "[查找 Inode] 当前目录级别：" << level << endl;
+
+                // 如果非最后一级的 level 不是目录
+                if (ptr_file_type != 'd' && &level != &dir_vector.back())
+                {
+                    dout << "[查找 Inode] 当前目录级别不是目录，查找失败！" << endl;
+                    dir_inode_id = -1;
+                    file_inode_id = -1;
+                    return;
+                }
+
+                // 查找目录项
+                Dentry dentry;
+                bool found = _lookup_dentry(ptr_inode_id, level, dentry);
+                if (found)
+                {
+                    dout << "[查找 Inode] 寻找到目录项 " << level << "（inode_id: " << dentry.inode_id << "）" << endl;
+
+                    // 如果还不是最后一个目录项
+                    if (&level != &dir_vector.back())
+                    {
+                        // 则需要继续往下找
+                        ptr_inode_id = dentry.inode_id;
+                        ptr_file_type = dentry.file_type;
+                        dout << "[查找 Inode] 继续向下一级寻找，ptr_inode_id: " << ptr_inode_id << endl;
+                    }
+                    else
+                    {
+                        // 否则找到了文件
+                        dir_inode_id = ptr_inode_id;
+                        file_inode_id = dentry.inode_id;
+                        dout << "[查找 Inode] 找到了最终项 " << level << "，此时 dir_inode_id: " << dir_inode_id << "，file_inode_id: " << file_inode_id << endl;
+                    }
+                }
+
+                if (!found)
+                {
+                    // 找到了次末级目录，但是没有找到最终项（文件/文件夹）
+                    // 如果是最后一个，则说明文件不存在，否则说明目录不存在
+                    if (&level == &dir_vector.back())
+                    {
+                        dir_inode_id = ptr_inode_id;
+                        file_inode_id = -1;
+                        dout << "[查找 Inode] 文件 " << level << " 不存在" << endl;
+                    }
+                    else
+                    // 否则则是在中途找不到目录的情况
+                    {
+                        dir_inode_id = -1;
+                        file_inode_id = -1;
+                        dout << "[查找 Inode] 目录 " << level << " 不存在" << endl;
+                    }
+                    return;
+                }
+            }
+
+        dout << "[查找 Inode] 根据路径查找 Inode 结果：" << endl;
+        dout << "[查找 Inode] dir_inode_id: " << dir_inode_id << endl;
+        dout << "[查找 Inode] file_inode_id: " << file_inode_id << endl;
+    }
+
+    string _filename(const string path)
+    {
+        vector<string> dir_vector = _split_path(path);
+        if (dir_vector.empty())
+            return "";
+        else
+        {
+            dout << "文件名为 " << dir_vector.back() << endl;
+            return dir_vector.back();
+        }
+    }
+
+    // 向目录新增一个目录项需要新申请的块数：已有空闲位置时为 0，否则为追加的 Dentry 数据块及其需要的地址块
+    int _dentry_block_need(const INode &dir_inode)
+    {
+        const int block_num = dir_inode.file_size / BLOCK_SIZE;
+        if (dir_inode.dentry_cnt < block_num * DENTRY_NUM_PER_BLOCK)
+            return 0;
+        return Util::block_occupation(block_num + 1) - Util::block_occupation(block_num);
+    }
+
+    int _dentry_block_need(const short &dir_inode_id)
+    {
+        return _dentry_block_need(_get_inode(dir_inode_id));
+    }
+
+    // 新增目录项，需要追加 Dentry 数据块而可用块不足时返回 false，此时不改动任何内容
+    bool _add_dentry(INode &dir_inode, const short &new_inode_id, const string &filename)
+    {
+        TRACE_SCOPE("_add_dentry");
+        dout << "[新增目录项] 正在向如下 INode 新增目录项 " << filename << "（INode ID 为" << new_inode_id << "）..." << endl;
+        dout << dir_inode << endl;
+
+        if (dir_inode.file_type != 'd')
+        {
+            dout << "[新增目录项] 该 INode 不是目录，新增目录项失败！" << endl;
+            return false;
+        }
+
+        INode _inode = _get_inode(new_inode_id);
+
+        // 从提示位置开始查找第一个有空闲位置的 Dentry 数据块（提示之前的块均已满）
+        const int block_num = dir_inode.file_size / BLOCK_SIZE;
+        vector<Dentry> dentry_list(DENTRY_NUM_PER_BLOCK);
+        int block_idx;
+        short block_id = -1;
+        int slot = -1;
+        for (block_idx = dir_inode.free_block_hint; block_idx < block_num; block_idx++)
+        {
+            block_id = _get_block_id(dir_inode, block_idx);
+            _load(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+            auto it = find_if(dentry_list.begin(), dentry_list.end(), [](const Dentry &dentry)
+                              { return dentry.inode_id == -1; });
+            if (it != dentry_list.end())
+            {
+                slot = it - dentry_list.begin();
+                break;
+            }
+        }
+
+        // 所有 Dentry 数据块均已满，在末尾追加一个（按需申请间接与二级间接地址块）
+        int new_block_cnt = 0;
+        if (slot == -1)
+        {
+            // 地址块在 _append_block_list 中申请，先确认连同 Dentry 数据块都有可用块
+            const int block_need = Util::block_occupation(block_num + 1) - Util::block_occupation(block_num);
+            if (_available_block_num() < block_need || (block_id = _get_avail_block(_inode_group(dir_inode.id))) == -1)
+            {
+                dout << "[新增目录项] 追加 Dentry 数据块需要 " << block_need << " 个块，可用块不足，新增目录项失败！" << endl;
+                return false;
+            }
+            dentry_list.assign(DENTRY_NUM_PER_BLOCK, Dentry());
+            slot = 0;
+            new_block_cnt = 1 + _append_block_list(dir_inode, block_num, {block_id});
+            // INode 的文件大小增加一个数据块的大小
+            dir_inode.file_size += BLOCK_SIZE;
+            dout << "[新增目录项] 该 INode 目前没有空闲的 Dentry 位置，新增第 " << block_idx << " 个 Dentry 数据块：" << block_id << endl;
+        }
+
+        // 设置 Dentry
+        dentry_list[slot] = Dentry(new_inode_id, filename, _inode.file_type);
+        _dump(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+        if (_inode.file_type == 'f')
+            _track_link(new_inode_id, dir_inode.id, true);
+        dir_inode.free_block_hint = block_idx;
+        auto filter_it = dentry_filters.find(dir_inode.id);
+        if (filter_it != dentry_filters.end())
+            filter_it->second.insert(filename);
+        dout << "[新增目录项] Dentry 数据块 " << block_id << " 的第 " << slot << " 个 Dentry 已设置为 " << endl;
+        dout << dentry_list[slot] << endl;
+
+        // INode 硬链接数加 1
+        _inode.link_cnt++;
+        _save_inode(_inode);
+
+        // 新目录项所指子树的用量及新增的块计入当前目录及其祖先（同时保存目录 INode）
+        dir_inode.dentry_cnt++;
+        _update_subtree_usage(dir_inode, _inode.subtree_inode_cnt, _inode.subtree_block_cnt + new_block_cnt);
+
+        dout << "[新增目录项] 新增目录项成功！" << endl;
+        return true;
+    }
+
+    bool _add_dentry(const short &dir_inode_id, const short &new_inode_id, const string &filename)
+    {
+        INode dir_inode = _get_inode(dir_inode_id);
+        return _add_dentry(dir_inode, new_inode_id, filename);
+    }
+
+    // filename 非空时只删除同名的目录项（同一目录下可能有指向同一 INode 的多个硬链接）
+    void _remove_dentry(const short &dir_inode_id, const short &inode_id, const string &filename = "")
+    {
+        TRACE_SCOPE("_remove_dentry");
+        vector<short> block_id_list = _get_block_list(dir_inode_id);
+        vector<Dentry> dentry_list(DENTRY_NUM_PER_BLOCK);
+        for (size_t block_idx = 0; block_idx < block_id_list.size(); block_idx++)
+        {
+            const short &block_id = block_id_list[block_idx];
+            _load(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+            for (auto &dentry : dentry_list)
+                // 找到了需要删除的目录项
+                if (dentry.inode_id == inode_id && (filename.empty() || dentry.get_filename() == filename))
+                {
+                    const char file_type = dentry.file_type;
+                    dentry = Dentry();
+                    _dump(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+                    if (file_type == 'f')
+                        _track_link(inode_id, dir_inode_id, false);
+
+                    // 文件自身硬链接数减一
+                    INode inode = _get_inode(inode_id);
+                    inode.link_cnt--;
+                    _save_inode(inode);
+                    dout << "[删除目录项] 目录项对应的 INode 硬链接数减 1：" << endl
+                         << inode;
+
+                    // 如果是目录，父目录的硬链接数减一
+                    INode dir_inode = _get_inode(dir_inode_id);
+                    if (file_type == 'd')
+                    {
+                        dir_inode.link_cnt--;
+                        dout << "[删除目录项] 目录项为目录，其父目录的 INode 硬链接数减 1：" << endl
+                             << dir_inode;
+                    }
+
+                    // 从当前目录及其祖先中扣除该子树的用量（同时保存目录项计数与硬链接数）
+                    dir_inode.dentry_cnt--;
+                    dir_inode.free_block_hint = min<int>(dir_inode.free_block_hint, block_idx);
+                    _update_subtree_usage(dir_inode, -inode.subtree_inode_cnt, -inode.subtree_block_cnt);
+
+                    // 目录项过于稀疏时压缩目录
+                    _maybe_compact_dir(dir_inode);
+
+                    return;
+                }
+        }
+    }
+
+    // 将有效目录项按原顺序紧凑地写回前部的 Dentry 块，释放尾部空闲的 Dentry 块及变空的地址块
+    // . 与 .. 始终位于第一个块的前两项；返回释放的块数
+    int _compact_dir(INode &dir_inode)
+    {
+        TRACE_SCOPE("_compact_dir");
+        vector<short> block_id_list = _get_block_list(dir_inode);
+
+        vector<Dentry> live_list;
+        vector<Dentry> dentry_list(DENTRY_NUM_PER_BLOCK);
+        for (const auto &block_id : block_id_list)
+        {
+            _load(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+            for (const auto &dentry : dentry_list)
+                if (dentry.inode_id != -1)
+                    live_list.push_back(dentry);
+        }
+
+        // 目录的 Dentry 块在逻辑上总是连续的，故块数即逻辑块数
+        const int old_block_num = block_id_list.size();
+        const int new_block_num = max(1, int(live_list.size() + DENTRY_NUM_PER_BLOCK - 1) / DENTRY_NUM_PER_BLOCK);
+        dout << "[压缩目录] INode " << dir_inode.id << " 共 " << live_list.size() << " 个有效目录项，Dentry 块数 " << old_block_num << " -> " << new_block_num << endl;
+        if (new_block_num >= old_block_num)
+            return 0;
+
+        for (int i = 0; i < new_block_num; i++)
+        {
+            vector<Dentry> packed(DENTRY_NUM_PER_BLOCK);
+            const int end = min(int(live_list.size()), (i + 1) * DENTRY_NUM_PER_BLOCK);
+            std::copy(live_list.begin() + i * DENTRY_NUM_PER_BLOCK, live_list.begin() + end, packed.begin());
+            _dump(packed.data(), BLOCK_START + block_id_list[i] * BLOCK_SIZE, BLOCK_SIZE);
+        }
+
+        const int freed_block_num = _truncate_block_list(dir_inode, old_block_num, new_block_num);
+        dir_inode.file_size = new_block_num * BLOCK_SIZE;
+        dir_inode.dentry_cnt = live_list.size();
+        dir_inode.free_block_hint = live_list.size() / DENTRY_NUM_PER_BLOCK;
+        _save_inode(dir_inode);
+
+        // 过滤器中残留着已删除的名称，按压缩后的目录项重建
+        dentry_filters.erase(dir_inode.id);
+        if (new_block_num >= BLOOM_MIN_BLOCK_NUM)
+            _build_dentry_filter(dir_inode, live_list);
+        _update_subtree_usage(dir_inode, 0, -freed_block_num);
+        return freed_block_num;
+    }
+
+    // 有效目录项占用率低于 1/DIR_COMPACT_THRESHOLD 时压缩目录
+    // 压缩后占用率接近 100%，需再删除大部分目录项才会再次触发，不会反复压缩
+    void _maybe_compact_dir(INode &dir_inode)
+    {
+        const int block_num = dir_inode.file_size / BLOCK_SIZE;
+        if (block_num > 1 && dir_inode.dentry_cnt * DIR_COMPACT_THRESHOLD < block_num * DENTRY_NUM_PER_BLOCK)
+            _compact_dir(dir_inode);
+    }
+
+    vector<Dentry> _load_dentries(const INode &inode)
+    {
+        TRACE_SCOPE("_load_dentries");
+        dout << "[读取目录项] 读取如下 INode 的目录项 ..." << endl;
+        dout << inode << endl;
+
+        if (inode.file_type != 'd')
+        {
+            dout << "[读取目录项] 该 INode 不是目录，读取失败！" << endl;
+            return {};
+        }
+
+        vector<short> block_id_list = _get_block_list(inode);
+        dout << "[读取目录项] 该 INode 对应的 Dentry 数据块：" << block_id_list << endl;
+
+        // 全部 Dentry 块一次批量读取
+        vector<Dentry> dentry(block_id_list.size() * DENTRY_NUM_PER_BLOCK);
+        _load_blocks(block_id_list, (char *)dentry.data());
+
+        vector<Dentry> dentry_list;
+        for (const auto &entry : dentry)
+            if (entry.inode_id != -1)
+                dentry_list.push_back(entry);
+
+        // dout << "[读取目录项] 有效 Dentry：" << endl
+        //      << dentry_list << endl;
+        return dentry_list;
+    }
+
+    vector<Dentry> _load_dentries(short inode_id)
+    {
+        INode inode = _get_inode(inode_id);
+        return _load_dentries(inode);
+    }
+
+    void _save_inode(const short &inode_id, const char &file_type, const int &file_size)
+    {
+        dout << "[保存 Inode] 保存如下 Inode ..." << endl;
+        INode inode = INode();
+        inode.id = inode_id;
+        inode.file_type = file_type;
+        inode.file_size = file_size;
+        inode.create_time = Util::get_current_time();
+        inode.modify_time = Util::get_current_time();
+        dout << inode;
+        _dump(&inode, INODE_TABLE_START + inode_id * INODE_SIZE, INODE_CLASS_SIZE);
+    }
+
+    void _save_inode(const INode &inode)
+    {
+        _dump(&inode, INODE_TABLE_START + inode.id * INODE_SIZE, INODE_CLASS_SIZE);
+    }
+
+    INode _get_inode(const short &inode_id)
+    {
+        INode inode = INode();
+        _load(&inode, INODE_TABLE_START + inode_id * INODE_SIZE, INODE_CLASS_SIZE);
+        assert(inode.id == inode_id);
+        return inode;
+    }
+
+    const vector<short> _inode_cnt(const short &inode_id)
+    {
+        TRACE_SCOPE("_inode_cnt");
+        vector<short> cnt;
+        const INode inode = _get_inode(inode_id);
+
+        // 文件
+        if (inode.file_type != 'd')
+            cnt.push_back(inode.id);
+
+        else if (inode.file_type == 'd')
+        {
+            cnt.push_back(inode.id);
+            vector<Dentry> dentry_list = _load_dentries(inode);
+            for (const auto &dentry : dentry_list)
+                if (dentry.inode_id != -1 && dentry.get_filename() != "." && dentry.get_filename() != "..")
+                {
+                    // 文件无需读取其 INode
+                    if (dentry.file_type != 'd')
+                    {
+                        cnt.push_back(dentry.inode_id);
+                        continue;
+                    }
+                    vector<short> temp = _inode_cnt(dentry.inode_id);
+                    cnt.insert(cnt.end(), temp.begin(), temp.end());
+                }
+        }
+
+        return cnt;
+    }
+
+    // 子树占用的 INode 数，直接读取 INode 中维护的统计值
+    const short inode_cnt(const short &inode_id)
+    {
+        TRACE_SCOPE("inode_cnt");
+        const short sum = _get_inode(inode_id).subtree_inode_cnt;
+        dout << "[统计 Inode 数量] INode " << inode_id << " 的子树 INode 数量: " << sum << endl;
+        return sum;
+    }
+
+    // 子树占用的数据块与地址块总数，直接读取 INode 中维护的统计值
+    const short block_cnt(const short &inode_id)
+    {
+        TRACE_SCOPE("block_cnt");
+        const short cnt = _get_inode(inode_id).subtree_block_cnt;
+        dout << "[统计块数量] INode " << inode_id << " 占用总块数：" << cnt << endl;
+        return cnt;
+    }
+
+    string _load_file(const INode &inode)
+    {
+        TRACE_SCOPE("_load_file");
+        dout << "[加载文件] 加载如下 INode 的文件内容 ..." << endl;
+        dout << inode << endl;
+
+        vector<short> block_id_list = _get_block_list(inode);
+
+        dout << "[加载文件] 该文件有 " << block_id_list.size() << " 个数据块：" << endl;
+        for (const auto &block_id : block_id_list)
+            dout << block_id << " ";
+        dout << endl;
+
+        // 全部数据块一次批量读取
+        string file_data_str(block_id_list.size() * BLOCK_SIZE, '\0');
+        if (inode.compressed)
+            file_data_str = _load_packed(inode, 0, inode.file_size - Util::rest_size(inode.file_size));
+        else
+            _load_blocks(block_id_list, file_data_str.data());
+        const string rest = _load_rest(inode);
+        file_data_str.resize(inode.file_size - rest.size());
+        file_data_str += rest;
+
+        return file_data_str;
+    }
+
+    // 创建文件并返回其 INode ID；可用块不足时退回已申请的 INode 与块，返回 -1
+    const short _create_file(const short &dir_inode_id, const string &filename, const int &file_size, const bool &compressed)
+    {
+        TRACE_SCOPE("_create_file");
+        // 文件的 INode 与数据块放在其所在目录的分配组内
+        short new_inode_id = _get_avail_inode(_inode_group(dir_inode_id));
+        dout << "[创建文件] 已申请新 Inode：" << new_inode_id << endl;
+
+        // Inode
+        _save_inode(new_inode_id, 'f', file_size);
+        if (compressed)
+        {
+            INode inode = _get_inode(new_inode_id);
+            inode.compressed = true;
+            _save_inode(inode);
+        }
+
+        auto abandon = [&]
+        {
+            dout << "[创建文件] 可用块不足，退回 INode " << new_inode_id << " 及已申请的块" << endl;
+            _free_inode(_get_inode(new_inode_id));
+            return -1;
+        };
+
+        // 数据块（地址块在 _set_block_list 中申请，先确认连同地址块都有可用块）
+        vector<short> block_id_list;
+        const int block_num = Util::data_block_num(file_size, compressed);
+        if (_available_block_num() < Util::block_occupation(block_num) || !_get_avail_blocks(block_num, _inode_group(new_inode_id), block_id_list))
+            return abandon();
+        dout << "[创建文件] 已申请 " << block_num << " 个块：" << block_id_list << endl;
+        _set_block_list(new_inode_id, block_id_list);
+
+        // 不占用独立数据块的内容（内联数据或尾部片段）
+        if (Util::rest_size(file_size) > 0)
+        {
+            INode inode = _get_inode(new_inode_id);
+            if (!_store_rest(inode, _random_content(Util::rest_size(file_size))))
+                return abandon();
+            _save_inode(inode);
+        }
+
+        // 目录项（在块分配之后添加，使目录的子树用量包含新文件的全部块）
+        if (!_add_dentry(dir_inode_id, new_inode_id, filename))
+            return abandon();
+
+        // 向数据块写入随机内容
+        if (compressed)
+        {
+            INode inode = _get_inode(new_inode_id);
+            _store_packed(inode, 0, _random_content(file_size - Util::rest_size(file_size)));
+        }
+        else
+            _fill_random_content(block_id_list);
+
+        return new_inode_id;
+    }
+
+    void _fill_random_content(const vector<short> &block_id_list)
+    {
+        srand(static_cast<unsigned int>(time(0)));
+        for (const auto &id : block_id_list)
+        {
+            vector<char> content(BLOCK_SIZE);
+            for (int i = 0; i < BLOCK_SIZE; i++)
+                content[i] = 'a' + rand() % 26;
+            // content[i] = '0' + i % 10;
+            // dout << "[创建文件] 写入数据块 " << id << " 内容：" << endl
+            //      << content << endl;
+            _dump_data(content.data(), BLOCK_START + id * BLOCK_SIZE, BLOCK_SIZE);
+        }
+    }
+
+    string _random_content(const int &size)
+    {
+        string content(size, '\0');
+        for (auto &c : content)
+            c = 'a' + rand() % 26;
+        return content;
+    }
+
+    // 为尾部片段分配打包块中连续的空闲槽位并写入内容（首次适配），没有合适的打包块时申请新块
+    // 申请不到新块时返回 false，INode 仍没有尾部片段
+    bool _pack_tail(INode &inode, const string &tail)
+    {
+        const uint32_t run_mask = (1u << ((tail.size() + TAIL_SLOT_SIZE - 1) / TAIL_SLOT_SIZE)) - 1;
+        const int run_len = __builtin_popcount(run_mask);
+        inode.tail_block = -1;
+        for (auto it = tail_blocks.begin(); it != tail_blocks.end() && inode.tail_block == -1; ++it)
+            for (int slot = 0; slot + run_len <= TAIL_SLOT_NUM; slot++)
+                if (!(it->second.slot_mask & (run_mask << slot)))
+                {
+                    inode.tail_block = it->first;
+                    inode.tail_offset = slot * TAIL_SLOT_SIZE;
+                    break;
+                }
+        if (inode.tail_block == -1)
+        {
+            inode.tail_block = _get_avail_block(_inode_group(inode.id));
+            if (inode.tail_block == -1)
+            {
+                dout << "[尾部打包] 没有可用块存放 INode " << inode.id << " 的尾部片段" << endl;
+                return false;
+            }
+            inode.tail_offset = 0;
+            dout << "[尾部打包] 申请新的打包块 " << inode.tail_block << endl;
+        }
+        dout << "[尾部打包] INode " << inode.id << " 的 " << tail.size() << " 字节尾部片段放入打包块 " << inode.tail_block << " 偏移 " << inode.tail_offset << endl;
+        _mark_tail(inode, true);
+        _dump_data(tail.data(), BLOCK_START + inode.tail_block * BLOCK_SIZE + inode.tail_offset, tail.size());
+        return true;
+    }
+
+    // 读取不占用独立数据块的内容：内联文件为全部内容，尾部打包的文件为最后的片段
+    string _load_rest(const INode &inode)
+    {
+        if (inode.is_inline())
+            return string(inode.inline_data, inode.file_size);
+        if (inode.tail_block == -1)
+            return "";
+        string tail(Util::tail_size(inode.file_size), '\0');
+        _load(tail.data(), BLOCK_START + inode.tail_block * BLOCK_SIZE + inode.tail_offset, tail.size());
+        return tail;
+    }
+
+    // 释放内联数据与尾部片段（须在修改 file_size 之前调用），打包块中不再有片段时一并释放
+    void _release_rest(INode &inode)
+    {
+        fill_n(inode.inline_data, INLINE_DATA_SIZE, 0);
+        if (inode.tail_block == -1)
+            return;
+        _mark_tail(inode, false);
+        if (tail_blocks[inode.tail_block].tail_num == 0)
+        {
+            dout << "[尾部打包] 打包块 " << inode.tail_block << " 已空，释放" << endl;
+            tail_blocks.erase(inode.tail_block);
+            _clear_block(inode.tail_block);
+        }
+        inode.tail_block = -1;
+        inode.tail_offset = 0;
+    }
+
+    // 按当前 file_size 存放不占用独立数据块的内容（内联或尾部打包），调用前需已释放原有的内联数据与尾部片段
+    // 尾部片段申请不到打包块时返回 false
+    bool _store_rest(INode &inode, const string &rest)
+    {
+        assert((int)rest.size() == Util::rest_size(inode.file_size));
+        if (inode.is_inline())
+            copy_n(rest.data(), rest.size(), inode.inline_data);
+        else if (!rest.empty())
+            return _pack_tail(inode, rest);
+        return true;
+    }
+
+    // 将文件调整为 file_size 字节，只申请或释放差额部分的块并原地更新 INode
+    // 内联数据与尾部片段先取出，再按新的大小放回 INode、打包块或首个新增的数据块
+    // 新增的数据块先全部申请，并确认地址块与可能需要的打包块也有可用块，不足时返回 false，此时不改动文件
+    bool _resize_file(const short &dir_inode_id, INode &inode, const int &file_size)
+    {
+        TRACE_SCOPE("_resize_file");
+        const int old_block_num = Util::data_block_num(inode.file_size, inode.compressed);
+        const int new_block_num = Util::data_block_num(file_size, inode.compressed);
+        int block_delta = 0;
+
+        vector<short> block_id_list;
+        if (new_block_num > old_block_num)
+        {
+            const int extra_need = Util::block_occupation(new_block_num) - Util::block_occupation(old_block_num) - (new_block_num - old_block_num) + (Util::tail_size(file_size) > 0);
+            if (!_get_avail_blocks(new_block_num - old_block_num, _inode_group(inode.id), block_id_list))
+                return false;
+            if (_available_block_num() < extra_need)
+            {
+                dout << "[调整文件大小] 地址块与打包块还需要 " << extra_need << " 个块，可用块不足，退回已申请的数据块" << endl;
+                _clear_block(block_id_list);
+                return false;
+            }
+        }
+
+        string rest = _load_rest(inode);
+        _release_rest(inode);
+
+        if (inode.compressed)
+            block_delta = _resize_packed(inode, file_size, rest, block_id_list);
+        else if (new_block_num > old_block_num)
+        {
+            dout << "[调整文件大小] 追加数据块：" << block_id_list << endl;
+            block_delta = block_id_list.size() + _append_block_list(inode, old_block_num, block_id_list);
+            _fill_random_content(block_id_list);
+            if (!rest.empty())
+            {
+                dout << "[调整文件大小] 原有的 " << rest.size() << " 字节尾部内容移入数据块 " << block_id_list[0] << endl;
+                _dump_data(rest.data(), BLOCK_START + block_id_list[0] * BLOCK_SIZE, rest.size());
+                rest.clear();
+            }
+        }
+        else if (new_block_num < old_block_num)
+        {
+            // 新的尾部内容位于截断后的第一个数据块中
+            rest.assign(Util::rest_size(file_size), '\0');
+            if (!rest.empty())
+            {
+                const short block_id = _get_block_id(inode, new_block_num);
+                dout << "[调整文件大小] 数据块 " << block_id << " 的前 " << rest.size() << " 字节移入尾部内容" << endl;
+                _load(rest.data(), BLOCK_START + block_id * BLOCK_SIZE, rest.size());
+            }
+            block_delta = -_truncate_block_list(inode, old_block_num, new_block_num);
+        }
+
+        // 尾部内容保留原有部分，增长的部分填充随机内容
+        const size_t rest_size = Util::rest_size(file_size);
+        if (rest.size() > rest_size)
+            rest.resize(rest_size);
+        else
+            rest += _random_content(rest_size - rest.size());
+
+        // 打包块已在前面确认，这里申请不到时说明可用块被并发的命令占用，尾部内容丢弃，文件大小退回到数据块的末尾
+        inode.file_size = file_size;
+        if (!_store_rest(inode, rest))
+        {
+            dout << "[调整文件大小] 尾部片段没有可用的打包块，文件大小退回 " << file_size - rest_size << "B" << endl;
+            inode.file_size = file_size - rest_size;
+        }
+        inode.modify_time = Util::get_current_time();
+        inode.subtree_block_cnt += block_delta;
+        _save_inode(inode);
+
+        // 用量按目录项计算，文件的每个硬链接所在的目录链都要更新
+        _update_file_usage(dir_inode_id, inode, block_delta);
+        return inode.file_size == file_size;
+    }
+
+    // 调整压缩文件数据块中的内容，rest 为原有的内联数据或尾部片段，返回时为新的尾部内容中保留的部分
+    // 压缩流中的内容以字节而非块为单位增减：增长时原有的尾部内容与新增的随机内容一并压缩写入，缩短时新的尾部内容从压缩流中读出
+    // block_id_list 为已申请的新增数据块，返回数据块与地址块的增减数
+    int _resize_packed(INode &inode, const int &file_size, string &rest, const vector<short> &block_id_list)
+    {
+        const int old_size = inode.file_size - Util::rest_size(inode.file_size);
+        const int new_size = file_size - Util::rest_size(file_size);
+        const int old_block_num = Util::data_block_num(inode.file_size, true);
+        const int new_block_num = Util::data_block_num(file_size, true);
+        int block_delta = 0;
+
+        if (new_size > old_size)
+        {
+            dout << "[调整文件大小] 压缩文件追加数据块：" << block_id_list << endl;
+            block_delta = block_id_list.size() + _append_block_list(inode, old_block_num, block_id_list);
+            _store_packed(inode, old_size, rest + _random_content(new_size - old_size - rest.size()));
+            rest.clear();
+        }
+        else if (new_size < old_size)
+        {
+            rest = _load_packed(inode, new_size, file_size);
+            if (new_block_num < old_block_num)
+                block_delta = -_truncate_block_list(inode, old_block_num, new_block_num);
+        }
+        return block_delta;
+    }
+
+    // 调整文件大小（字节），relative 为 true 时在当前大小上追加 file_size
+    bool _resize_file(const string &cmd, const string &path, const int &file_size, bool relative)
+    {
+        // 将路径转为绝对路径
+        string absolute_path = _absolute_path(path);
+
+        // 根据路径查找 Inode
+        short dir_inode_id, file_inode_id;
+        _search_inode(path, dir_inode_id, file_inode_id);
+
+        if (file_inode_id == -1)
+        {
+            cout << cmd << ": cannot open '" << absolute_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        INode file_inode = _get_inode(file_inode_id);
+        if (file_inode.file_type != 'f')
+        {
+            cout << cmd << ": cannot open '" << absolute_path << "': Is a directory" << endl;
+            return false;
+        }
+
+        const int old_file_size = file_inode.file_size;
+        const long long new_file_size = relative ? (long long)old_file_size + file_size : file_size;
+        if (new_file_size > MAX_FILE_SIZE)
+        {
+            cout << cmd << ": cannot resize '" << absolute_path << "': File too large" << endl;
+            return false;
+        }
+
+        // 尾部片段可能需要新的打包块，按多占一块估计
+        if (!_reserve_blocks(Util::block_occupation(Util::data_block_num(new_file_size, file_inode.compressed)) + (Util::tail_size(new_file_size) > 0) - Util::block_occupation(Util::data_block_num(old_file_size, file_inode.compressed))))
+        {
+            cout << cmd << ": cannot resize '" << absolute_path << "': No available block" << endl;
+            return false;
+        }
+
+        if (!_resize_file(dir_inode_id, file_inode, new_file_size))
+        {
+            cout << cmd << ": cannot resize '" << absolute_path << "': No available block" << endl;
+            return false;
+        }
+        dout << "[调整文件大小] 文件 " << absolute_path << " 大小：" << old_file_size << "B -> " << new_file_size << "B" << endl;
+        return true;
+    }
+
+    // 在文件末尾追加 append_size 字节的随机内容
+    bool append_file(const string &path, const int &append_size)
+    {
+        TRACE_SCOPE("append_file");
+        TransactionScope transaction(*this);
+        return _resize_file("append", path, append_size, true);
+    }
+
+    // 将文件截断（或扩展）为 file_size 字节
+    bool truncate_file(const string &path, const int &file_size)
+    {
+        TRACE_SCOPE("truncate_file");
+        TransactionScope transaction(*this);
+        return _resize_file("truncate", path, file_size, false);
+    }
+
+    // 将 size 字节写入文件数据块中从 offset 开始的位置（压缩文件为压缩流中的偏移），共享的数据块先复制一份再写入
+    // 写时复制需要的块先全部申请，可用块不足时返回 false，此时不写入任何内容
+    bool _write_blocks(INode &inode, const int &offset, const char *data, const int &size)
+    {
+        int shared_block_num = 0;
+        for (int idx = offset / BLOCK_SIZE; idx * BLOCK_SIZE < offset + size; idx++)
+            shared_block_num += block_refs.count(_get_block_id(inode, idx));
+        vector<short> new_block_id_list;
+        if (!_get_avail_blocks(shared_block_num, _inode_group(inode.id), new_block_id_list))
+            return false;
+
+        auto new_block_it = new_block_id_list.begin();
+        for (int pos = offset; pos < offset + size;)
+        {
+            const int idx = pos / BLOCK_SIZE;
+            const int end = min(offset + size, (idx + 1) * BLOCK_SIZE);
+            short block_id = _get_block_id(inode, idx);
+            if (block_refs.count(block_id))
+            {
+                // 写时复制
+                const short new_block_id = *new_block_it++;
+                dout << "[写时复制] INode " << inode.id << " 的第 " << idx << " 个数据块：共享块 " << block_id << " 复制到 " << new_block_id << endl;
+                vector<char> content(BLOCK_SIZE);
+                _load(content.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+                _dump_data(content.data(), BLOCK_START + new_block_id * BLOCK_SIZE, BLOCK_SIZE);
+                _set_block_id(inode, idx, new_block_id);
+                _clear_block(block_id);
+                block_id = new_block_id;
+            }
+            _dump_data(data + pos - offset, BLOCK_START + block_id * BLOCK_SIZE + pos % BLOCK_SIZE, end - pos);
+            pos = end;
+        }
+        return true;
+    }
+
+    // 读取压缩文件数据块中 [begin, end) 字节的内容
+    string _load_packed(const INode &inode, const int &begin, const int &end)
+    {
+        const int group_begin = begin / PACK_GROUP_SIZE;
+        const int group_end = (end + PACK_GROUP_SIZE - 1) / PACK_GROUP_SIZE;
+        string content(_unpack_buffer_size(group_end - group_begin), '\0');
+        _unpack_groups([&](const int &idx)
+                       { return _get_block_id(inode, idx); }, group_begin, group_end, content.data());
+        return content.substr(begin - group_begin * PACK_GROUP_SIZE, end - begin);
+    }
+
+    // 将内容压缩后写入压缩文件数据块中从 begin 字节开始的位置（所需的数据块须已分配），首尾不足一组的部分先读出原内容再合并
+    // 写时复制申请不到块时返回 false
+    bool _store_packed(INode &inode, const int &begin, const string &data)
+    {
+        TRACE_SCOPE("_store_packed");
+        const int end = begin + data.size();
+        const int group_begin = begin / PACK_GROUP_SIZE;
+        const int group_end = (end + PACK_GROUP_SIZE - 1) / PACK_GROUP_SIZE;
+        string content((group_end - group_begin) * PACK_GROUP_SIZE, 'a');
+        if (begin % PACK_GROUP_SIZE)
+            content.replace(0, PACK_GROUP_SIZE, _load_packed(inode, group_begin * PACK_GROUP_SIZE, (group_begin + 1) * PACK_GROUP_SIZE));
+        if (end % PACK_GROUP_SIZE && group_end - 1 > group_begin)
+            content.replace(content.size() - PACK_GROUP_SIZE, PACK_GROUP_SIZE, _load_packed(inode, (group_end - 1) * PACK_GROUP_SIZE, group_end * PACK_GROUP_SIZE));
+        content.replace(begin - group_begin * PACK_GROUP_SIZE, data.size(), data);
+
+        string packed((group_end - group_begin) * PACK_GROUP_BYTES, '\0');
+        Util::pack_letters(content.data(), group_end - group_begin, packed.data());
+        return _write_blocks(inode, group_begin * PACK_GROUP_BYTES, packed.data(), packed.size());
+    }
+
+    // 从 offset 处覆写文件内容（不改变文件大小），共享的数据块先复制一份再写入
+    // 写时复制申请不到块时返回 false，此时文件内容不变
+    bool _write_file(INode &inode, const int &offset, const string &data)
+    {
+        TRACE_SCOPE("_write_file");
+        const int content_size = inode.file_size - Util::rest_size(inode.file_size);
+        if (offset < content_size)
+        {
+            const int size = min((int)data.size(), content_size - offset);
+            const bool written = inode.compressed ? _store_packed(inode, offset, data.substr(0, size)) : _write_blocks(inode, offset, data.data(), size);
+            if (!written)
+                return false;
+        }
+
+        // 内联数据或尾部片段
+        const int rest_start = inode.file_size - Util::rest_size(inode.file_size);
+        if (inode.is_inline())
+            std::copy(data.begin(), data.end(), inode.inline_data + offset);
+        else if (inode.tail_block != -1 && offset + (int)data.size() > rest_start)
+        {
+            const int begin = max(offset, rest_start);
+            _dump_data(data.data() + begin - offset, BLOCK_START + inode.tail_block * BLOCK_SIZE + inode.tail_offset + begin - rest_start, offset + data.size() - begin);
+        }
+
+        inode.modify_time = Util::get_current_time();
+        _save_inode(inode);
+        return true;
+    }
+
+    // 覆写文件中从 offset 字节开始的内容
+    bool write_file(const string &path, const int &offset, const string &data)
+    {
+        TRACE_SCOPE("write_file");
+        TransactionScope transaction(*this);
+        string absolute_path = _absolute_path(path);
+
+        short dir_inode_id, file_inode_id;
+        _search_inode(path, dir_inode_id, file_inode_id);
+
+        if (file_inode_id == -1)
+        {
+            cout << "write: cannot open '" << absolute_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        INode file_inode = _get_inode(file_inode_id);
+        if (file_inode.file_type != 'f')
+        {
+            cout << "write: cannot open '" << absolute_path << "': Is a directory" << endl;
+            return false;
+        }
+
+        if (offset < 0 || offset + (long long)data.size() > file_inode.file_size)
+        {
+            cout << "write: cannot write '" << absolute_path << "': Offset out of range" << endl;
+            return false;
+        }
+
+        if (file_inode.compressed && !Util::is_packable(data))
+        {
+            cout << "write: cannot write '" << absolute_path << "': Compressed file only stores lowercase letters" << endl;
+            return false;
+        }
+
+        // 写时复制需要的块数（压缩文件按写入范围在压缩流中所在的数据块计算）
+        int begin = offset, end = offset + data.size();
+        if (file_inode.compressed)
+        {
+            begin = begin / PACK_GROUP_SIZE * PACK_GROUP_BYTES;
+            end = Util::packed_size(end);
+        }
+        int shared_block_num = 0;
+        for (int idx = begin / BLOCK_SIZE; idx < Util::data_block_num(file_inode.file_size, file_inode.compressed) && idx * BLOCK_SIZE < end; idx++)
+            shared_block_num += block_refs.count(_get_block_id(file_inode, idx));
+        if (!_reserve_blocks(shared_block_num))
+        {
+            cout << "write: cannot write '" << absolute_path << "': No available block" << endl;
+            return false;
+        }
+
+        if (!_write_file(file_inode, offset, data))
+        {
+            cout << "write: cannot write '" << absolute_path << "': No available block" << endl;
+            return false;
+        }
+        return true;
+    }
+
+    // 传入文件路径和文件大小（字节），创建文件
+    bool create_file(const string &path, const int &file_size)
+    {
+        TRACE_SCOPE("create_file");
+        TransactionScope transaction(*this);
+        // 将路径转为绝对路径
+        string absolute_path = _absolute_path(path);
+
+        dout << "[创建文件] 准备创建 " << absolute_path << "，文件大小为 " << file_size << "B" << endl;
+
+        // 根据路径查找 Inode
+        short dir_inode_id, file_inode_id;
+        _search_inode(path, dir_inode_id, file_inode_id);
+
+        if (dir_inode_id == -1)
+        {
+            // cout << "[创建文件] 路径 " << absolute_path << " 无效" << endl;
+            cout << "touch: cannot touch '" << absolute_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        // 如果 file_inode_id 不为 -1，则说明文件已存在
+        if (file_inode_id != -1)
+        {
+            // cout << "[创建文件] 文件 " << absolute_path << " 已存在" << endl;
+            cout << "touch: cannot touch '" << absolute_path << "': File exists" << endl;
+            return false;
+        }
+
+        if (_available_inode_num() == 0)
+        {
+            // cout << "[创建文件] 可用 Inode 不足，文件创建失败！" << endl;
+            cout << "touch: cannot touch '" << absolute_path << "': No available inode" << endl;
+            return false;
+        }
+
+        if (file_size > MAX_FILE_SIZE)
+        {
+            cout << "touch: cannot touch '" << absolute_path << "': File too large" << endl;
+            return false;
+        }
+
+        // 数据块、地址块与可能需要的打包块，加上目录新增目录项可能需要的块
+        if (!_reserve_blocks(Util::block_occupation(Util::data_block_num(file_size, compress_new_files)) + (Util::tail_size(file_size) > 0) + _dentry_block_need(dir_inode_id)))
+        {
+            // cout << "[创建文件] 可用块不足，文件创建失败！创建大小为 " << filesize_kb << "KB 的文件需要 " << Util::block_occupation(filesize_kb) << " 个块，目前可用块剩余 " << _available_block_num() << " 个" << endl;
+            cout << "touch: cannot touch '" << absolute_path << "': No available block" << endl;
+            return false;
+        }
+
+        short new_inode_id = _create_file(dir_inode_id, _filename(path), file_size, compress_new_files);
+        if (new_inode_id == -1)
+        {
+            cout << "touch: cannot touch '" << absolute_path << "': No available block" << endl;
+            return false;
+        }
+
+        dout << "[创建文件] 新 Inode 信息：" << endl;
+        dout << _get_inode(new_inode_id) << endl;
+
+        dout << "[创建文件] 文件 " << absolute_path << " 创建成功" << endl;
+
+        return true;
+    }
+
+    // 创建目录并返回其 INode ID；可用块不足时退回已申请的 INode 与块，返回 -1
+    const short _create_dir(const short &dir_inode_id, const string &new_dirname)
+    {
+        TRACE_SCOPE("_create_dir");
+        // 新目录的 Dentry 数据块，加上父目录新增目录项可能需要的块
+        if (_available_block_num() < 1 + _dentry_block_need(dir_inode_id))
+        {
+            dout << "[创建目录] 可用块不足，目录创建失败！" << endl;
+            return -1;
+        }
+
+        // 申请新可用 Inode 和 Block
+        // 按 Orlov 策略选择分配组，目录的第一个 Dentry 块与其 INode 同组
+        short new_inode_id = _get_avail_inode(_find_dir_group(dir_inode_id));
+        alloc_groups[_inode_group(new_inode_id)].dir_num++;
+        dout << "[创建目录] 已申请新 Inode：" << new_inode_id << endl;
+
+        short new_block_id = _get_avail_block(_inode_group(new_inode_id));
+        if (new_block_id == -1)
+        {
+            dout << "[创建目录] 可用块不足，退回 INode " << new_inode_id << endl;
+            alloc_groups[_inode_group(new_inode_id)].dir_num--;
+            _clear_inode(new_inode_id);
+            return -1;
+        }
+        dout << "[创建目录] 已申请新 Block：" << new_block_id << endl;
+
+        // 初始化 Inode
+        _save_inode(new_inode_id, 'd', BLOCK_SIZE);
+
+        // 初始化 Dentry 数据块
+        _create_blank_dentries(new_block_id, new_inode_id, dir_inode_id);
+
+        // 向新文件所在的目录添加目录项
+        if (!_add_dentry(dir_inode_id, new_inode_id, new_dirname))
+        {
+            dout << "[创建目录] 可用块不足，退回 INode " << new_inode_id << " 及其 Dentry 数据块" << endl;
+            INode parent_dir_inode = _get_inode(dir_inode_id);
+            parent_dir_inode.link_cnt--;
+            _save_inode(parent_dir_inode);
+            _free_inode(_get_inode(new_inode_id));
+            return -1;
+        }
+
+        return new_inode_id;
+    }
+
+    bool create_dir(const string path, bool parent = false)
+    {
+        TRACE_SCOPE("create_dir");
+        TransactionScope transaction(*this);
+        // 将路径转为绝对路径
+        string absolute_path = _absolute_path(path);
+
+        dout << "[创建目录] 准备创建 " << absolute_path << " ..." << endl;
+
+        if (_available_inode_num() == 0)
+        {
+            // cout << "[创建目录] 可用 Inode 不足，目录创建失败！" << endl;
+            cout << "mkdir: cannot create directory '" << absolute_path << "': No available inode" << endl;
+            return false;
+        }
+
+        // 根据路径查找 Inode
+        short dir_inode_id, file_inode_id;
+        _search_inode(path, dir_inode_id, file_inode_id);
+
+        // 如果 file_inode_id 不为 -1，则说明文件已存在
+        if (file_inode_id != -1)
+        {
+            // cout << "[创建目录] " << absolute_path << " 已存在" << endl;
+            cout << "mkdir: cannot create directory '" << absolute_path << "': File exists" << endl;
+            return false;
+        }
+
+        if (!parent && dir_inode_id == -1)
+        {
+            // cout << "[创建目录] 路径 " << absolute_path << " 无效" << endl;
+            cout << "mkdir: cannot create directory '" << absolute_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        // 每个新目录一个 Dentry 数据块，加上已有的最深一级目录新增目录项可能需要的块（新目录中总有空位）
+        vector<string> dir_vector = _split_path(absolute_path);
+        int new_dir_num = 1;
+        short existing_dir_inode_id = dir_inode_id;
+        if (parent)
+        {
+            existing_dir_inode_id = ROOT_INODE_ID;
+            new_dir_num = dir_vector.size();
+            for (const auto &level : dir_vector)
+            {
+                const short level_inode_id = _search_inode(existing_dir_inode_id, level);
+                if (level_inode_id == -1)
+                    break;
+                existing_dir_inode_id = level_inode_id;
+                new_dir_num--;
+            }
+        }
+        if (!_reserve_blocks(new_dir_num + _dentry_block_need(existing_dir_inode_id)))
+        {
+            dout << "[创建目录] 可用块不足，目录创建失败！此时的超级块信息：" << endl;
+            dout << superblock;
+            // cout << "[创建目录] 可用块不足，目录创建失败！" << endl;
+            cout << "mkdir: cannot create directory '" << absolute_path << "': No available block" << endl;
+            return false;
+        }
+
+        short new_inode_id;
+        if (!parent)
+            new_inode_id = _create_dir(dir_inode_id, _filename(path));
+
+        else if (parent)
+        {
+            short _dir_inode_id = ROOT_INODE_ID;
+            short _ptr_inode_id;
+            for (const auto &level : dir_vector)
+            {
+                _ptr_inode_id = _search_inode(_dir_inode_id, level);
+
+                if (_ptr_inode_id == -1 && (_ptr_inode_id = _create_dir(_dir_inode_id, level)) == -1)
+                    break;
+
+                _dir_inode_id = _ptr_inode_id;
+            }
+            new_inode_id = _ptr_inode_id;
+        }
+
+        if (new_inode_id == -1)
+        {
+            cout << "mkdir: cannot create directory '" << absolute_path << "': No available block" << endl;
+            return false;
+        }
+
+        dout << "[创建目录] 新 Inode 信息：" << endl;
+        dout << _get_inode(new_inode_id) << endl;
+
+        dout << "[创建目录] 目录 " << absolute_path << " 创建成功" << endl;
+
+        return true;
+    }
+
+    // 删除文件时按 filename 删除目录项：同一目录下可能有指向同一文件的多个硬链接
+    void _remove(const short &dir_inode_id, const short &file_inode_id, const string &filename = "")
+    {
+        TRACE_SCOPE("_remove");
+        // 删除特定文件
+        if (file_inode_id > 0)
+        {
+            INode file_inode = _get_inode(file_inode_id);
+            dout << "[删除文件] 正在删除如下文件：" << endl;
+            dout << file_inode;
+
+            // 删除该文件对应的目录项
+            _remove_dentry(dir_inode_id, file_inode_id, filename);
+
+            // 如果文件自身硬链接数降为 0，则彻底删除文件
+            if (_get_inode(file_inode_id).link_cnt == 0)
+            {
+                dout << "[删除文件] 文件硬链接数此时为 0，彻底删除文件 ..." << endl;
+                _free_inode(file_inode);
+            }
+            return;
+        }
+
+        else if (file_inode_id == -1)
+        // 删除整个文件夹
+        {
+            // 列出所有目录项
+            vector<Dentry> dentry_list = _load_dentries(dir_inode_id);
+            for (const auto &dentry : dentry_list)
+                if (dentry.inode_id != -1 && dentry.get_filename() != "." && dentry.get_filename() != "..")
+                {
+                    // 如果是文件
+                    if (dentry.file_type == 'f')
+                        _remove(dir_inode_id, dentry.inode_id, dentry.get_filename());
+                    // 如果是文件夹
+                    if (dentry.file_type == 'd')
+                        _remove(dentry.inode_id, -1);
+                    // 每删除一项即为一致的状态，可以提前提交
+                    _commit_between_steps();
+                }
+
+            // 此时已经是目录下为空
+            dentry_list = _load_dentries(dir_inode_id);
+            dout << "目录下的所有文件/文件夹已被递归删除，此时目录项为：" << endl;
+            dout << dentry_list;
+
+            // 删除该目录在其父目录中的目录项
+            dout << "[删除目录] 删除该目录在其父目录中的目录项 ..." << endl;
+            short parent_dir_inode_id = dentry_list[1].inode_id;
+            _remove_dentry(parent_dir_inode_id, dir_inode_id);
+
+            // 释放目录的数据块、地址块与 INode
+            _free_inode(_get_inode(dir_inode_id));
+        }
+    }
+
+    // 释放 INode 及其全部数据块、地址块与尾部片段（调用前需确认已无目录项指向它）
+    void _free_inode(const INode &inode)
+    {
+        // 释放尾部片段
+        INode rest_inode = inode;
+        _release_rest(rest_inode);
+
+        // 释放数据块
+        vector<short> block_id_list = _get_block_list(inode);
+        dout << "[释放 INode] 释放 INode " << inode.id << " 的数据块：" << block_id_list << endl;
+        _clear_block(block_id_list);
+
+        // 释放间接地址块
+        vector<short> addr_block_list = _get_addr_block_list(inode);
+        dout << "[释放 INode] 释放 INode " << inode.id << " 的地址块：" << addr_block_list << endl;
+        _clear_block(addr_block_list);
+
+        // 释放 INode（INode ID 会被复用，一并丢弃其目录项过滤器）
+        dentry_filters.erase(inode.id);
+        if (inode.file_type == 'd')
+            alloc_groups[_inode_group(inode.id)].dir_num--;
+        _clear_inode(inode.id);
+    }
+
+    bool remove(const string &path, bool recursive = false)
+    {
+        TRACE_SCOPE("remove");
+        TransactionScope transaction(*this);
+        // 将路径转为绝对路径
+        string absolute_path = _absolute_path(path);
+
+        dout << "[删除文件/目录] 准备删除 " << absolute_path << " ..." << endl;
+
+        if (absolute_path == "/")
+        {
+            // cout << "[删除文件/目录] 根目录不可删除" << endl;
+            cout << "rm: cannot remove root directory" << endl;
+            return false;
+        }
+
+        if (absolute_path == working_dir)
+        {
+            // cout << "[删除文件/目录] 当前工作目录不可删除" << endl;
+            cout << "rm: cannot remove current working directory" << endl;
+            return false;
+        }
+
+        if (path == "." || path == ".." || Util::ends_with(path, "/.") || Util::ends_with(path, "/.."))
+        {
+            // cout << "[删除文件/目录] 不可删除 '.' 或 '..'" << endl;
+            cout << "rm: cannot remove '.' or '..'" << endl;
+            return false;
+        }
+
+        // 根据路径查找 Inode
+        short dir_inode_id, file_inode_id;
+        _search_inode(path, dir_inode_id, file_inode_id);
+
+        if (file_inode_id == -1)
+        {
+            // cout << "[删除文件/目录] 文件 " << absolute_path << " 不存在" << endl;
+            cout << "rm: cannot remove '" << absolute_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        const INode file_inode = _get_inode(file_inode_id);
+
+        if (file_inode.file_type == 'f')
+        {
+            dout << "[删除文件/目录] 准备删除文件 " << absolute_path << " ..." << endl;
+            _remove(dir_inode_id, file_inode_id, _filename(absolute_path));
+            dout << "[删除文件/目录] 文件 " << absolute_path << " 已删除" << endl;
+        }
+
+        else if (file_inode.file_type == 'd')
+        {
+            if (!recursive)
+            {
+                // cout << "[删除文件/目录] 无法删除目录 " << absolute_path << "，如需删除，请使用 rm -r" << endl;
+                cout << "rm: cannot remove '" << absolute_path << "': Is a directory" << endl;
+                cout << "rm: use 'rm -r' to remove a directory" << endl;
+                return false;
+            }
+            else if (recursive)
+            {
+                dout << "[删除文件/目录] 准备删除目录 " << absolute_path << " ..." << endl;
+                _remove(file_inode_id, -1);
+                dout << "[删除文件/目录] 目录 " << absolute_path << " 已删除" << endl;
+            }
+        }
+
+        return true;
+    }
+
+    // 可用块不足时返回 false，已复制的部分保留
+    bool _copy(const short &src_inode_id, const short &dst_dir_inode_id, const string &dst_filename)
+    {
+        TRACE_SCOPE("_copy");
+        // 假设已经完成了一切检查，此函数仅作执行操作
+        const INode src_inode = _get_inode(src_inode_id);
+        dout << "[复制文件/目录] 正在复制文件/目录 " << src_inode_id << " 到目录 " << dst_dir_inode_id << "，目标文件名为 " << dst_filename << " ..." << endl;
+        dout << "[复制文件/目录] 源文件/目录信息：" << endl;
+        dout << src_inode;
+        dout << "[复制文件/目录] 目标目录信息：" << endl;
+        dout << _get_inode(dst_dir_inode_id);
+
+        if (src_inode.file_type == 'f')
+        {
+            // 新建指定名称的文件，与源文件采用相同的存放格式
+            short new_inode_id = _create_file(dst_dir_inode_id, dst_filename, src_inode.file_size, src_inode.compressed);
+            if (new_inode_id == -1)
+                return false;
+
+            // 复制数据块
+            // 复制数据块，源文件经预读器顺序读取（压缩文件逐块解压后重新压缩写入）
+            FileReader reader(*this, src_inode);
+            if (src_inode.compressed)
+            {
+                INode new_inode = _get_inode(new_inode_id);
+                const int content_size = src_inode.file_size - Util::rest_size(src_inode.file_size);
+                for (int i = 0; i < reader.get_block_num(); i++)
+                    _store_packed(new_inode, i * BLOCK_SIZE, string(reader.block(i), min(BLOCK_SIZE, content_size - i * BLOCK_SIZE)));
+            }
+            else
+            {
+                vector<short> dst_block_id_list = _get_block_list(new_inode_id);
+                for (int i = 0; i < reader.get_block_num(); i++)
+                    _dump_data(reader.block(i), BLOCK_START + dst_block_id_list[i] * BLOCK_SIZE, BLOCK_SIZE);
+            }
+
+            // 复制内联数据或尾部片段（新文件创建时已为其分配好位置，原地覆写即可）
+            if (Util::rest_size(src_inode.file_size) > 0)
+            {
+                INode new_inode = _get_inode(new_inode_id);
+                _write_file(new_inode, src_inode.file_size - Util::rest_size(src_inode.file_size), _load_rest(src_inode));
+            }
+        }
+        else if (src_inode.file_type == 'd')
+        {
+            dout << "[复制文件/目录] 准备迭代复制目录下的文件/目录 ..." << endl;
+
+            // 新建指定名称的目录
+            short new_inode_id = _create_dir(dst_dir_inode_id, dst_filename);
+            if (new_inode_id == -1)
+                return false;
+
+            // 递归复制源文件夹下的文件，每复制完一项即为一致的状态，可以提前提交
+            vector<Dentry> dentry_list = _load_dentries(src_inode_id);
+            for (const auto &dentry : dentry_list)
+                if (dentry.inode_id != -1 && dentry.get_filename() != "." && dentry.get_filename() != "..")
+                {
+                    if (!_copy(dentry.inode_id, new_inode_id, dentry.get_filename()))
+                        return false;
+                    _commit_between_steps();
+                }
+        }
+        return true;
+    }
+
+    bool copy(const string &src_path, const string &dst_path, bool recursive = false)
+    {
+        TRACE_SCOPE("copy");
+        TransactionScope transaction(*this);
+        // 将路径转为绝对路径
+        string absolute_src_path = _absolute_path(src_path);
+        string absolute_dst_path = _absolute_path(dst_path);
+
+        dout << "[复制文件/目录] 准备复制 " << absolute_src_path << " 到 " << absolute_dst_path << " ..." << endl;
+
+        // 根据路径查找 Inode
+        short src_dir_inode_id, src_file_inode_id;
+        _search_inode(src_path, src_dir_inode_id, src_file_inode_id);
+
+        short dst_dir_inode_id, dst_file_inode_id;
+        _search_inode(dst_path, dst_dir_inode_id, dst_file_inode_id);
+
+        if (src_file_inode_id == -1)
+        {
+            // cout << "[复制文件/目录] 源文件/目录 " << absolute_src_path << " 不存在" << endl;
+            cout << "cp: cannot copy '" << absolute_src_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        const INode src_file_inode = _get_inode(src_file_inode_id);
+
+        if (dst_dir_inode_id == -1)
+        {
+            // cout << "[复制文件/目录] 目标路径 " << absolute_dst_path << " 有误" << endl;
+            cout << "cp: cannot copy into '" << absolute_dst_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        if (dst_file_inode_id > 0 && _get_inode(dst_file_inode_id).file_type == 'f')
+        {
+            dout << "[复制文件/目录] 目标文件/目录 " << absolute_dst_path << " 已存在，其 INode 如下：" << endl;
+            dout << _get_inode(dst_file_inode_id);
+            cout << "cp: cannot copy into '" << absolute_dst_path << "': File exists" << endl;
+            return false;
+        }
+
+        const short src_inode_cnt = inode_cnt(src_file_inode_id);
+
+        if (_available_inode_num() < src_inode_cnt)
+        {
+            dout << "[复制文件/目录] 可用 Inode 不足，复制失败！源文件/目录占用 " << src_inode_cnt << " 个 Inode，目前可用 Inode 剩余 " << _available_inode_num() << " 个" << endl;
+            cout << "cp: cannot copy '" << absolute_src_path << "': No available inode" << endl;
+            return false;
+        }
+
+        const short src_block_cnt = block_cnt(src_file_inode_id);
+
+        // 目标已存在时为目录（已存在的文件在前面报错），复制到其中；目标目录新增目录项可能需要额外的块
+        const short target_dir_inode_id = dst_file_inode_id == -1 ? dst_dir_inode_id : dst_file_inode_id;
+        if (!_reserve_blocks(src_block_cnt + _dentry_block_need(target_dir_inode_id)))
+        {
+            dout << "[复制文件/目录] 可用块不足，复制失败！源文件/目录占用 " << src_block_cnt << " 个块，目前可用块剩余 " << _available_block_num() << " 个" << endl;
+            cout << "cp: cannot copy '" << absolute_src_path << "': No available block" << endl;
+            return false;
+        }
+
+        bool copied = true;
+        if (src_file_inode.file_type == 'f')
+        {
+            if (dst_file_inode_id == -1)
+            {
+                dout << "[复制文件/目录] 准备将源文件 " << absolute_src_path << " 复制到目标路径 " << absolute_dst_path << " ..." << endl;
+                copied = _copy(src_file_inode_id, dst_dir_inode_id, _filename(dst_path));
+            }
+
+            else if (_get_inode(dst_file_inode_id).file_type == 'd')
+            {
+                dout << "[复制文件/目录] 准备将源文件 " << absolute_src_path << " 复制到目标路径 " << absolute_dst_path + "/" + _filename(src_path) << " ..." << endl;
+                copied = _copy(src_file_inode_id, dst_file_inode_id, _filename(src_path));
+            }
+        }
+
+        else if (src_file_inode.file_type == 'd')
+        {
+            if (!recursive)
+            {
+                // cout << "[复制文件/目录] 无法复制目录 " << absolute_src_path << "，如需复制，请使用 cp -r" << endl;
+                cout << "cp: cannot copy '" << absolute_src_path << "': Is a directory" << endl;
+                cout << "cp: use 'cp -r' to copy a directory" << endl;
+                return false;
+            }
+            else if (recursive)
+            {
+                if (dst_file_inode_id == -1)
+                {
+                    dout << "[复制文件/目录] 准备将源文件 " << absolute_src_path << " 复制到目标路径 " << absolute_dst_path << " ..." << endl;
+                    copied = _copy(src_file_inode_id, dst_dir_inode_id, _filename(dst_path));
+                }
+
+                else if (_get_inode(dst_file_inode_id).file_type == 'd')
+                {
+                    dout << "[复制文件/目录] 准备将源文件 " << absolute_src_path << " 复制到目标路径 " << absolute_dst_path + "/" + _filename(src_path) << " ..." << endl;
+                    copied = _copy(src_file_inode_id, dst_file_inode_id, _filename(src_path));
+                }
+            }
+        }
+
+        if (!copied)
+        {
+            cout << "cp: cannot copy '" << absolute_src_path << "': No available block" << endl;
+            return false;
+        }
+
+        dout << "[复制文件/目录] 文件/目录 " << absolute_src_path << " 已成功复制到 " << absolute_dst_path << endl;
+
+        return true;
+    }
+
+    // 判断 dir_inode_id 是否为 ancestor_inode_id 本身或其子孙目录（沿 .. 向上查找）
+    bool _is_descendant(short dir_inode_id, const short &ancestor_inode_id)
+    {
+        while (dir_inode_id != ancestor_inode_id)
+        {
+            if (dir_inode_id == ROOT_INODE_ID)
+                return false;
+            dir_inode_id = _get_parent_inode_id(_get_inode(dir_inode_id));
+        }
+        return true;
+    }
+
+    // 将目录中名为 filename 的目录项原地改为指向 new_inode_id（仅写一次数据块），返回其原先指向的 INode ID
+    short _replace_dentry(const short &dir_inode_id, const string &filename, const short &new_inode_id, const char &file_type)
+    {
+        vector<short> block_id_list = _get_block_list(dir_inode_id);
+        vector<Dentry> dentry_list(DENTRY_NUM_PER_BLOCK);
+        for (const auto &block_id : block_id_list)
+        {
+            _load(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+            for (auto &dentry : dentry_list)
+                if (dentry.inode_id != -1 && dentry.get_filename() == filename)
+                {
+                    short old_inode_id = dentry.inode_id;
+                    if (dentry.file_type == 'f')
+                        _track_link(old_inode_id, dir_inode_id, false);
+                    if (file_type == 'f')
+                        _track_link(new_inode_id, dir_inode_id, true);
+                    dentry.inode_id = new_inode_id;
+                    dentry.file_type = file_type;
+                    _dump(dentry_list.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+                    return old_inode_id;
+                }
+        }
+        return -1;
+    }
+
+    // 将目录的 .. 目录项改为指向 parent_inode_id
+    void _set_parent_inode_id(const INode &dir_inode, const short &parent_inode_id)
+    {
+        vector<Dentry> dentry_list(DENTRY_NUM_PER_BLOCK);
+        _load(dentry_list.data(), BLOCK_START + dir_inode.direct_block[0] * BLOCK_SIZE, BLOCK_SIZE);
+        dentry_list[1].inode_id = parent_inode_id;
+        _dump(dentry_list.data(), BLOCK_START + dir_inode.direct_block[0] * BLOCK_SIZE, BLOCK_SIZE);
+    }
+
+    // 移动/重命名：只在目录间转移目录项，不复制数据块
+    bool rename(const string &src_path, const string &dst_path)
+    {
+        TRACE_SCOPE("rename");
+        TransactionScope transaction(*this);
+        // 将路径转为绝对路径
+        string absolute_src_path = _absolute_path(src_path);
+        string absolute_dst_path = _absolute_path(dst_path);
+
+        dout << "[移动] 准备将 " << absolute_src_path << " 移动到 " << absolute_dst_path << " ..." << endl;
+
+        if (src_path == "." || src_path == ".." || Util::ends_with(src_path, "/.") || Util::ends_with(src_path, "/.."))
+        {
+            cout << "mv: cannot move '.' or '..'" << endl;
+            return false;
+        }
+
+        if (absolute_src_path == "/")
+        {
+            cout << "mv: cannot move root directory" << endl;
+            return false;
+        }
+
+        // 根据路径查找 Inode
+        short src_dir_inode_id, src_inode_id;
+        _search_inode(src_path, src_dir_inode_id, src_inode_id);
+
+        if (src_inode_id == -1)
+        {
+            cout << "mv: cannot stat '" << absolute_src_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        // 当前工作目录及其祖先不可移动，否则 working_dir 将失效
+        if (absolute_src_path == working_dir || working_dir.rfind(absolute_src_path + "/", 0) == 0)
+        {
+            cout << "mv: cannot move '" << absolute_src_path << "': Device or resource busy" << endl;
+            return false;
+        }
+
+        short dst_dir_inode_id, dst_inode_id;
+        _search_inode(dst_path, dst_dir_inode_id, dst_inode_id);
+
+        if (dst_dir_inode_id == -1)
+        {
+            cout << "mv: cannot move '" << absolute_src_path << "' to '" << absolute_dst_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        const INode src_inode = _get_inode(src_inode_id);
+        const string src_filename = _filename(src_path);
+
+        // 目标为已存在的目录时，移动到该目录之下
+        short target_dir_inode_id = dst_dir_inode_id;
+        string target_filename = _filename(dst_path);
+        short target_inode_id = dst_inode_id;
+        if (dst_inode_id != -1 && dst_inode_id != src_inode_id && _get_inode(dst_inode_id).file_type == 'd')
+        {
+            target_dir_inode_id = dst_inode_id;
+            target_filename = src_filename;
+            target_inode_id = _search_inode(target_dir_inode_id, target_filename);
+        }
+
+        // 源与目标是同一个文件
+        if (target_inode_id == src_inode_id)
+            return true;
+
+        if (src_inode.file_type == 'd' && _is_descendant(target_dir_inode_id, src_inode_id))
+        {
+            cout << "mv: cannot move '" << absolute_src_path << "' to a subdirectory of itself, '" << absolute_dst_path << "'" << endl;
+            return false;
+        }
+
+        if (target_inode_id != -1)
+        {
+            const INode target_inode = _get_inode(target_inode_id);
+            if (target_inode.file_type == 'd' && src_inode.file_type != 'd')
+            {
+                cout << "mv: cannot overwrite directory '" << absolute_dst_path << "' with non-directory" << endl;
+                return false;
+            }
+            if (target_inode.file_type != 'd' && src_inode.file_type == 'd')
+            {
+                cout << "mv: cannot overwrite non-directory '" << absolute_dst_path << "' with directory '" << absolute_src_path << "'" << endl;
+                return false;
+            }
+            if (target_inode.file_type == 'd' && _load_dentries(target_inode).size() > 2)
+            {
+                cout << "mv: cannot move '" << absolute_src_path << "' to '" << absolute_dst_path << "': Directory not empty" << endl;
+                return false;
+            }
+
+            // 原地改写目标目录项，目标路径始终指向旧文件或新文件之一
+            dout << "[移动] 目标已存在，原地替换其目录项 ..." << endl;
+            _replace_dentry(target_dir_inode_id, target_filename, src_inode_id, src_inode.file_type);
+
+            INode _src_inode = _get_inode(src_inode_id);
+            _src_inode.link_cnt++;
+            _save_inode(_src_inode);
+            _update_subtree_usage(target_dir_inode_id, src_inode.subtree_inode_cnt - target_inode.subtree_inode_cnt, src_inode.subtree_block_cnt - target_inode.subtree_block_cnt);
+
+            // 释放被覆盖的目标
+            INode old_inode = _get_inode(target_inode_id);
+            old_inode.link_cnt--;
+            if (old_inode.file_type == 'd')
+            {
+                // 被覆盖的空目录的 .. 不再指向目标目录
+                INode target_dir_inode = _get_inode(target_dir_inode_id);
+                target_dir_inode.link_cnt--;
+                _save_inode(target_dir_inode);
+                _free_inode(old_inode);
+            }
+            else if (old_inode.link_cnt == 0)
+                _free_inode(old_inode);
+            else
+                _save_inode(old_inode);
+        }
+        else if (!_reserve_blocks(_dentry_block_need(target_dir_inode_id)) || !_add_dentry(target_dir_inode_id, src_inode_id, target_filename))
+        {
+            cout << "mv: cannot move '" << absolute_src_path << "' to '" << absolute_dst_path << "': No available block" << endl;
+            return false;
+        }
+
+        // 删除源目录中的原目录项
+        _remove_dentry(src_dir_inode_id, src_inode_id, src_filename);
+
+        // 目录需修正 ..，并将 .. 带来的链接数从原父目录转到新父目录（原父目录已在 _remove_dentry 中减一）
+        if (src_inode.file_type == 'd')
+        {
+            _set_parent_inode_id(src_inode, target_dir_inode_id);
+            INode target_dir_inode = _get_inode(target_dir_inode_id);
+            target_dir_inode.link_cnt++;
+            _save_inode(target_dir_inode);
+        }
+
+        dout << "[移动] " << absolute_src_path << " 已移动到 " << absolute_dst_path << endl;
+        return true;
+    }
+
+    bool hard_link(const string &src_path, const string &dst_path)
+    {
+        TRACE_SCOPE("hard_link");
+        TransactionScope transaction(*this);
+        // 将路径转为绝对路径
+        string absolute_src_path = _absolute_path(src_path);
+        string absolute_dst_path = _absolute_path(dst_path);
+
+        dout << "[硬链接] 准备在 " << absolute_dst_path << " 创建硬链接，指向 " << absolute_src_path << " ..." << endl;
+
+        // 根据路径查找 Inode
+        short src_dir_inode_id, src_file_inode_id;
+        _search_inode(src_path, src_dir_inode_id, src_file_inode_id);
+
+        short dst_dir_inode_id, dst_file_inode_id;
+        _search_inode(dst_path, dst_dir_inode_id, dst_file_inode_id);
+
+        if (src_file_inode_id == -1)
+        {
+            // cout << "[硬链接] 源文件 " << absolute_src_path << " 不存在" << endl;
+            cout << "ln: cannot create link '" << absolute_dst_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        if (dst_file_inode_id != -1)
+        {
+            // cout << "[硬链接] 目标文件 " << absolute_dst_path << " 已存在" << endl;
+            cout << "ln: cannot create link '" << absolute_dst_path << "': File exists" << endl;
+            return false;
+        }
+
+        // 创建硬链接（仅新增目录项，不改动 INode 和数据块、地址块）
+        if (!_reserve_blocks(_dentry_block_need(dst_dir_inode_id)) || !_add_dentry(dst_dir_inode_id, src_file_inode_id, _filename(dst_path)))
+        {
+            cout << "ln: cannot create link '" << absolute_dst_path << "': No available block" << endl;
+            return false;
+        }
+        dout << "[硬链接] 硬链接 " << absolute_dst_path << " 已创建" << endl;
+
+        return true;
+    }
+
+    // 读取并打印文件内容
+    bool cat(const string &path)
+    {
+        TRACE_SCOPE("cat");
+        // 将路径转为绝对路径
+        string absolute_path = _absolute_path(path);
+
+        // 根据路径查找 Inode
+        short dir_inode_id, file_inode_id;
+        _search_inode(path, dir_inode_id, file_inode_id);
+
+        // 如果 file_inode_id 为 -1，则说明文件不存在
+        if (file_inode_id == -1)
+        {
+            // cout << "[查看文件内容] 文件 " << absolute_path << " 不存在" << endl;
+            cout << "cat: " << absolute_path << ": No such file or directory" << endl;
+            return false;
+        }
+
+        // 获取文件 INode
+        INode file_inode = _get_inode(file_inode_id);
+
+        // 如果不是文件
+        if (file_inode.file_type != 'f')
+        {
+            // cout << "[查看文件内容] " << absolute_path << " 不是文件" << endl;
+            cout << "cat: " << absolute_path << ": Is a directory" << endl;
+            return false;
+        }
+
+        // 读取文件内容：数据块经预读器逐块输出，输出与后续窗口的读取重叠进行，最后输出内联数据或尾部片段
+        FileReader reader(*this, file_inode);
+        // cout << "[查看文件内容] 文件 " << absolute_path << " 内容如下：" << endl;
+        for (int i = 0; i < reader.get_block_num(); i++)
+            cout.write(reader.block(i), min(BLOCK_SIZE, file_inode.file_size - i * BLOCK_SIZE));
+        const string rest = _load_rest(file_inode);
+        cout.write(rest.data(), rest.size());
+        cout << endl;
+        // cout << "-------------------------" << endl;
+
+        return true;
+    }
+
+    // 改变当前工作目录
+    bool change_dir(string path)
+    {
+        TRACE_SCOPE("change_dir");
+        // 将路径转为绝对路径
+        string absolute_path = _absolute_path(path);
+
+        if (absolute_path.empty())
+        {
+            // cout << "[切换工作目录] 路径 " << path << " 不合法" << endl;
+            cout << "cd: invalid path" << endl;
+            return false;
+        }
+
+        // 根据路径查找 Inode
+        short dir_inode_id, file_inode_id;
+        _search_inode(path, dir_inode_id, file_inode_id);
+        short _inode_id = file_inode_id;
+
+        // 如果 dir_inode_id 为 -1，则说明目录不存在
+        if (_inode_id == -1)
+        {
+            // cout << "[切换工作目录] " << absolute_path << " 不存在" << endl;
+            cout << "cd: " << absolute_path << ": No such file or directory" << endl;
+            return false;
+        }
+        else
+        {
+            INode dir_inode = _get_inode(_inode_id);
+            if (dir_inode.file_type != 'd')
+            {
+                // cout << "[切换工作目录] " << absolute_path << " 不是目录" << endl;
+                cout << "cd: " << absolute_path << ": Not a directory" << endl;
+                return false;
+            }
+            else
+            {
+                dout << "[切换工作目录] 当前工作目录：" << working_dir << " -> " << absolute_path << endl;
+                working_dir = absolute_path;
+                working_dir_inode_id = _inode_id;
+            }
+        }
+
+        return true;
+    }
+
+    bool list_dir(string path = "")
+    {
+        TRACE_SCOPE("list_dir");
+        short _inode_id, dir_inode_id;
+
+        // 将路径转为绝对路径
+        string absolute_path = _absolute_path(path);
+
+        if (path.empty())
+            _inode_id = working_dir_inode_id;
+        else if (path == "/")
+            _inode_id = ROOT_INODE_ID;
+        else
+            _search_inode(path, dir_inode_id, _inode_id);
+
+        // 如果 dir_inode_id 为 -1，则说明目录不存在
+        if (_inode_id == -1)
+        {
+            // cout << "[列出目录] " << absolute_path << " 不存在" << endl;
+            cout << "ls: cannot access '" << absolute_path << "': No such file or directory" << endl;
+            return false;
+        }
+        else
+        {
+            INode _inode = _get_inode(_inode_id);
+            if (_inode.file_type != 'd')
+            {
+                // cout << "[列出目录] " << absolute_path << " 不是目录" << endl;
+                cout << "ls: cannot access '" << absolute_path << "': Not a directory" << endl;
+                return false;
+            }
+            else
+            {
+                vector<Dentry> dentry_list = _load_dentries(_inode);
+                // cout << "[列出目录] 目录 " << absolute_path << " 内容如下：" << endl;
+                for (const auto &dentry : dentry_list)
+                {
+                    if (dentry.inode_id != -1)
+                    {
+                        INode inode = _get_inode(dentry.inode_id);
+                        // cout << setw(4) << inode.id << "  ";
+                        if (inode.file_type == 'd')
+                            // cout << "目录 ";
+                            cout << " dir ";
+                        else if (inode.file_type == 'f')
+                            // cout << "文件 ";
+                            cout << "file ";
+                        else
+                            // cout << "未知 ";
+                            cout << "unkn ";
+                        cout << setw(2) << inode.link_cnt << "  ";
+                        cout << setw(4) << Util::readable_size(inode.file_size) << "  ";
+                        cout << Util::time_to_string(inode.create_time) << " ";
+                        cout << Util::time_to_string(inode.modify_time) << "  ";
+                        // 文件名
+                        if (inode.file_type == 'd')
+                            cout << BOLD << BLUE << dentry.get_filename() << RESET << endl;
+                        else
+                            cout << dentry.get_filename() << endl;
+                    }
+                }
+                // cout << "------------------------------------------" << endl;
+            }
+        }
+
+        return true;
+    }
+
+    bool stat(const string &path)
+    {
+        TRACE_SCOPE("stat");
+        // 将路径转为绝对路径
+        string absolute_path = _absolute_path(path);
+
+        // 根据路径查找 Inode
+        short dir_inode_id, file_inode_id;
+        _search_inode(path, dir_inode_id, file_inode_id);
+
+        // 如果 file_inode_id 为 -1，则说明文件不存在
+        if (file_inode_id == -1)
+        {
+            // cout << "[查看文件状态] 文件 " << absolute_path << " 不存在" << endl;
+            cout << "stat: cannot stat '" << absolute_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        // 打印 INode 信息
+        cout << "File: " << absolute_path << endl;
+        cout << _get_inode(file_inode_id);
+
+        return true;
+    }
+
+    // 显示文件/目录子树的空间占用（O(1)，读取 INode 中维护的统计值）
+    bool disk_usage(const string &path)
+    {
+        TRACE_SCOPE("disk_usage");
+        // 将路径转为绝对路径
+        string absolute_path = _absolute_path(path);
+
+        // 根据路径查找 Inode
+        short dir_inode_id, file_inode_id;
+        _search_inode(path, dir_inode_id, file_inode_id);
+
+        if (file_inode_id == -1)
+        {
+            cout << "du: cannot access '" << absolute_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        const INode inode = _get_inode(file_inode_id);
+        cout << setw(4) << Util::readable_size(inode.subtree_block_cnt * BLOCK_SIZE) << "  "
+             << setw(5) << inode.subtree_block_cnt << " blocks  "
+             << setw(5) << inode.subtree_inode_cnt << " inodes  "
+             << absolute_path << endl;
+
+        return true;
+    }
+
+    // 手动压缩目录，释放删除目录项后留下的空闲 Dentry 块
+    bool compact_dir(const string &path)
+    {
+        TRACE_SCOPE("compact_dir");
+        TransactionScope transaction(*this);
+        // 将路径转为绝对路径
+        string absolute_path = _absolute_path(path);
+
+        // 根据路径查找 Inode
+        short dir_inode_id, file_inode_id;
+        _search_inode(path, dir_inode_id, file_inode_id);
+
+        if (file_inode_id == -1)
+        {
+            cout << "compact: cannot access '" << absolute_path << "': No such file or directory" << endl;
+            return false;
+        }
+
+        INode inode = _get_inode(file_inode_id);
+        if (inode.file_type != 'd')
+        {
+            cout << "compact: '" << absolute_path << "': Not a directory" << endl;
+            return false;
+        }
+
+        const int old_block_num = inode.file_size / BLOCK_SIZE;
+        const int freed_block_num = _compact_dir(inode);
+        cout << absolute_path << ": " << old_block_num << " -> " << inode.file_size / BLOCK_SIZE << " dentry blocks, "
+             << freed_block_num << " blocks freed" << endl;
+
+        return true;
+    }
+
+    // 离线去重：对全部文件的数据块计算指纹，内容相同的块合并为一个共享块，由引用数记录共享者
+    void dedup()
+    {
+        TRACE_SCOPE("dedup");
+        TransactionScope transaction(*this);
+        const auto start_time = chrono::steady_clock::now();
+        chrono::nanoseconds hash_time(0);
+
+        unordered_map<uint64_t, vector<short>> fingerprints; // 指纹 -> 内容互不相同的块
+        int64_t scanned_block_num = 0;
+        int merged_block_num = 0, reclaimed_block_num = 0;
+        vector<char> candidate(BLOCK_SIZE);
+        for (int i = 0; i < INODE_NUM; i++)
+        {
+            if (!inode_bitmap.get(i))
+                continue;
+            INode inode = _get_inode(i);
+            if (inode.file_type != 'f' || Util::data_block_num(inode.file_size) == 0)
+                continue;
+
+            vector<short> block_id_list = _get_block_list(inode);
+            vector<char> content(block_id_list.size() * BLOCK_SIZE);
+            _load_blocks(block_id_list, content.data());
+
+            bool inode_changed = false;
+            for (int idx = 0; idx < (int)block_id_list.size(); idx++)
+            {
+                const char *block = content.data() + idx * BLOCK_SIZE;
+                const auto hash_start = chrono::steady_clock::now();
+                const uint64_t fingerprint = Util::fnv1a(block, BLOCK_SIZE);
+                hash_time += chrono::steady_clock::now() - hash_start;
+                scanned_block_num++;
+
+                // 指纹相同时逐字节比较，排除哈希碰撞
+                vector<short> &same_fingerprint = fingerprints[fingerprint];
+                short target = -1;
+                for (const auto &block_id : same_fingerprint)
+                {
+                    if (block_id != block_id_list[idx])
+                        _load(candidate.data(), BLOCK_START + block_id * BLOCK_SIZE, BLOCK_SIZE);
+                    if (block_id == block_id_list[idx] || memcmp(candidate.data(), block, BLOCK_SIZE) == 0)
+                    {
+                        target = block_id;
+                        break;
+                    }
+                }
+                if (target == -1)
+                {
+                    same_fingerprint.push_back(block_id_list[idx]);
+                    continue;
+                }
+                if (target == block_id_list[idx])
+                    continue;
+
+                // 改为引用已有的块，原块的引用随之减少，没有其他引用时释放
+                dout << "[去重] INode " << inode.id << " 的逻辑块 " << idx << "：" << block_id_list[idx] << " -> " << target << endl;
+                _set_block_id(inode, idx, target);
+                inode_changed |= idx < NUM_DIRECT_BLOCK;
+                _add_block_ref(target);
+                if (!block_refs.count(block_id_list[idx]))
+                    reclaimed_block_num++;
+                _clear_block(block_id_list[idx]);
+                merged_block_num++;
+            }
+            if (inode_changed)
+                _save_inode(inode);
+        }
 
-        if (absolute_path == working_dir)
+        const double total_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count();
+        const double hash_ms = chrono::duration<double, milli>(hash_time).count();
+        const double scanned_mb = double(scanned_block_num) * BLOCK_SIZE / (1024 * 1024);
+        cout << "dedup: scanned " << scanned_block_num << " blocks (" << Util::readable_size(scanned_block_num * BLOCK_SIZE) << ") in "
+             << fixed << setprecision(1) << total_ms << " ms, hashed at "
+             << (hash_ms > 0 ? scanned_mb / (hash_ms / 1000) : 0.0) << " MB/s" << defaultfloat << endl;
+        cout << "dedup: " << merged_block_num << " duplicate blocks merged, "
+             << reclaimed_block_num << " blocks (" << Util::readable_size(reclaimed_block_num * BLOCK_SIZE) << ") reclaimed" << endl;
+    }
+
+    // 阻塞直到全部元数据与文件数据都已写回并落盘
+    void sync()
+    {
+        TRACE_SCOPE("sync");
+        _journal_flush();
+    }
+
+    // 显示回写队列与写入统计
+    void stats()
+    {
+        lock_guard<mutex> journal_lock(journal_mutex);
+        cout << "------------- Writeback Stats ------------" << endl;
+        cout << "I/O Backend:\t\t" << io.name() << endl;
+        cout << "Flusher:\t\t" << (flusher.joinable() ? "running" : "stopped") << endl;
+        cout << "Flush Interval:\t\t" << flush_interval_ms << " ms" << endl;
+        cout << "Dirty Threshold:\t" << Util::readable_size(flush_dirty_threshold) << endl;
+        cout << "------------------------------------------" << endl;
+        cout << "Pending Transactions:\t" << pending_transaction_num << endl;
+        cout << "Uncommitted Blocks:\t" << uncommitted_blocks.size() << endl;
+        cout << "Unwritten Journaled:\t" << committed_blocks.size() << endl;
+        cout << "Dirty Data Blocks:\t" << dirty_data_blocks.size() << endl;
+        cout << "Journal Used:\t\t" << journal_used_block_num << " / " << JOURNAL_BLOCK_NUM - 1 << " blocks" << endl;
+        cout << "------------------------------------------" << endl;
+        cout << "Flusher Wakeups:\t" << flush_stats.wakeup_num << endl;
+        cout << "Commits:\t\t" << flush_stats.commit_num << endl;
+        cout << "Checkpoints:\t\t" << flush_stats.checkpoint_num << endl;
+        cout << "Write Requests:\t\t" << flush_stats.write_num << endl;
+        cout << "Journal Written:\t" << Util::readable_size(flush_stats.journal_bytes) << endl;
+        cout << "Metadata Written:\t" << Util::readable_size(flush_stats.metadata_bytes) << endl;
+        cout << "Data Written:\t\t" << Util::readable_size(flush_stats.data_bytes) << endl;
+        cout << "Holes Punched:\t\t" << flush_stats.punch_num << " (" << Util::readable_size(flush_stats.punched_bytes) << ")" << endl;
+        cout << "Read Transfers:\t\t" << io.read_request_num << endl;
+        cout << "Write Transfers:\t" << io.write_request_num << endl;
+        cout << "Read-ahead Windows:\t" << readahead_stats.window_num << " (" << readahead_stats.block_num << " blocks)" << endl;
+        cout << "Read-ahead Prefetches:\t" << readahead_stats.prefetch_num << endl;
+        cout << "Read-ahead Hits:\t" << readahead_stats.hit_num << endl;
+        cout << "Ring Batches:\t\t" << io.batch_num << endl;
+        cout << "Ring Requests:\t\t" << io.request_num << endl;
+        cout << "Ring Syscalls:\t\t" << io.enter_num << endl;
+        cout << "------------------------------------------" << endl;
+        cout << "CRC32C:\t\t\t" << (Util::crc32c_hardware() ? "sse4.2" : "software") << endl;
+        cout << "Blocks Verified:\t" << checksum_stats.verified_num << endl;
+        cout << "Checksum Errors:\t" << checksum_stats.error_num << endl;
+        cout << "------------------------------------------" << endl;
+    }
+
+    // 丢弃全部空闲空间：提交并写回全部修改后，对所有块均空闲的主机页打洞
+    bool trim()
+    {
+        TRACE_SCOPE("trim");
+        _journal_flush();
+        lock_guard<mutex> journal_lock(journal_mutex);
+        set<int> page_list;
+        for (int i = 0; i < DATA_BLOCK_NUM; i++)
+            if (!block_bitmap.get(i))
+                page_list.insert((BLOCK_START + i * BLOCK_SIZE) / _host_page_size());
+        freed_blocks.clear();
+
+        const FlushStats old_stats = flush_stats;
+        if (!_punch_pages(page_list))
         {
-            // cout << "[删除文件/目录] 当前工作目录不可删除" << endl;
-            cout << "rm: cannot remove current working directory" << endl;
-            return;
+            cout << "trim: cannot punch holes in " << image_path << ": " << strerror(errno) << endl;
+            return false;
         }
+        struct stat image_stat;
+        fstat(fd, &image_stat);
+        cout << "trim: discarded " << Util::readable_size(flush_stats.punched_bytes - old_stats.punched_bytes) << " of free space in " << flush_stats.punch_num - old_stats.punch_num << " ranges, "
+             << image_path << " now occupies " << Util::readable_size((int64_t)image_stat.st_blocks * 512) << " on disk" << endl;
+        return true;
+    }
 
-        if (path == "." || path == ".." || Util::ends_with(path, "/.") || Util::ends_with(path, "/.."))
+    // 校验整个镜像：按线程数将块分段，各线程直接在映射的镜像上计算 CRC32C 并与校验和比较
+    bool scrub()
+    {
+        TRACE_SCOPE("scrub");
+        // 先提交并写回全部修改，使原位置上的内容与校验和对应；持锁期间回写线程不会写回，二者保持一致
+        lock_guard<mutex> journal_lock(journal_mutex);
+        _journal_commit();
+        _journal_checkpoint();
+        const char *image = (const char *)mmap(nullptr, FILESYSTEM_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+        if (image == MAP_FAILED)
         {
-            // cout << "[删除文件/目录] 不可删除 '.' 或 '..'" << endl;
-            cout << "rm: cannot remove '.' or '..'" << endl;
-            return;
+            cout << "scrub: cannot map image: " << strerror(errno) << endl;
+            return false;
         }
 
-        // 根据路径查找 Inode
-        short dir_inode_id, file_inode_id;
-        _search_inode(path, dir_inode_id, file_inode_id);
+        // 空闲数据块不校验：崩溃前写回了数据但未提交的块在恢复后是空闲的，其校验和没有随之生效
+        auto block_in_use = [&](const int &block_no)
+        {
+            const int block_id = block_no - BLOCK_START / BLOCK_SIZE;
+            return block_id < 0 || block_bitmap.get(block_id);
+        };
+
+        const auto start_time = chrono::steady_clock::now();
+        const int thread_num = max(1u, thread::hardware_concurrency());
+        vector<future<vector<int>>> results;
+        for (int t = 0; t < thread_num; t++)
+            results.push_back(async(launch::async, [&, t]
+                                    {
+                vector<int> corrupted;
+                int verified_num = 0;
+                for (int block_no = BLOCK_NUM * t / thread_num; block_no < BLOCK_NUM * (t + 1) / thread_num; block_no++)
+                    if (_has_checksum(block_no) && block_in_use(block_no))
+                    {
+                        verified_num++;
+                        if (Util::crc32c(image + block_no * BLOCK_SIZE, BLOCK_SIZE) != block_checksums[block_no])
+                            corrupted.push_back(block_no);
+                    }
+                corrupted.push_back(verified_num);
+                return corrupted; }));
+        // 各线程的结果末尾附带其校验的块数
+        vector<int> corrupted;
+        int verified_num = 0;
+        for (auto &result : results)
+        {
+            vector<int> part = result.get();
+            verified_num += part.back();
+            part.pop_back();
+            corrupted.insert(corrupted.end(), part.begin(), part.end());
+        }
+        const double elapsed_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count();
+        munmap((void *)image, FILESYSTEM_SIZE);
+
+        for (const auto &block_no : corrupted)
+            cout << "scrub: " << _block_name(block_no) << " checksum mismatch" << endl;
+        cout << "scrub: verified " << verified_num << " blocks (" << Util::readable_size((int64_t)verified_num * BLOCK_SIZE) << ") with " << thread_num << (thread_num > 1 ? " threads" : " thread") << " in " << fixed << setprecision(1) << elapsed_ms << " ms, "
+             << (elapsed_ms > 0 ? (double)verified_num * BLOCK_SIZE / 1024 / 1024 / (elapsed_ms / 1000) : 0.0) << " MB/s" << defaultfloat << endl;
+        cout << "scrub: " << corrupted.size() << " corrupted blocks" << endl;
+        return corrupted.empty();
+    }
 
-        if (file_inode_id == -1)
+    // 在镜像快照上收集 INode 引用的全部块（数据块、地址块与尾部打包块），目录另外解析出有效目录项
+    static void _fsck_scan_inode(const char *image, FsckScan &scan)
+    {
+        const INode &inode = scan.inode;
+        auto block_at = [&](const short &block_id)
         {
-            // cout << "[删除文件/目录] 文件 " << absolute_path << " 不存在" << endl;
-            cout << "rm: cannot remove '" << absolute_path << "': No such file or directory" << endl;
-            return;
+            return image + BLOCK_START + block_id * BLOCK_SIZE;
+        };
+        auto add_block = [&](const short &block_id)
+        {
+            if (block_id == -1)
+                return false;
+            if (block_id < 0 || block_id >= DATA_BLOCK_NUM)
+            {
+                scan.invalid_list.push_back(block_id);
+                return false;
+            }
+            scan.block_list.push_back(block_id);
+            return true;
+        };
+        vector<short> data_block_list;
+        auto add_data_block = [&](const short &block_id)
+        {
+            if (add_block(block_id))
+                data_block_list.push_back(block_id);
+        };
+
+        for (int i = 0; i < NUM_DIRECT_BLOCK; i++)
+            add_data_block(inode.direct_block[i]);
+        for (int i = 0; i < NUM_INDIRECT_BLOCK; i++)
+            if (add_block(inode.indirect_block[i]))
+            {
+                const short *addresses = (const short *)block_at(inode.indirect_block[i]);
+                for (int j = 0; j < ADDRESS_PER_BLOCK; j++)
+                    add_data_block(addresses[j]);
+            }
+        for (int i = 0; i < NUM_DOUBLE_INDIRECT_BLOCK; i++)
+            if (add_block(inode.double_indirect_block[i]))
+            {
+                const short *addresses = (const short *)block_at(inode.double_indirect_block[i]);
+                for (int j = 0; j < ADDRESS_PER_BLOCK; j++)
+                    if (add_block(addresses[j]))
+                    {
+                        const short *addresses2 = (const short *)block_at(addresses[j]);
+                        for (int k = 0; k < ADDRESS_PER_BLOCK; k++)
+                            add_data_block(addresses2[k]);
+                    }
+            }
+        if (inode.file_type == 'f' && inode.tail_block != -1)
+            add_block(inode.tail_block);
+
+        if (inode.file_type == 'd')
+            for (const auto &block_id : data_block_list)
+            {
+                const Dentry *dentry = (const Dentry *)block_at(block_id);
+                for (int i = 0; i < DENTRY_NUM_PER_BLOCK; i++)
+                    if (dentry[i].inode_id != -1)
+                        scan.dentry_list.push_back(dentry[i]);
+            }
+    }
+
+    // 全盘一致性检查：多线程扫描 INode 表，再由根目录遍历目录树，重新计算块与 INode 的占用、链接数以及子树用量，
+    // 与 bitmap、INode 中的链接数、目录项数与子树用量、分配组与超级块中的计数比对；repair 为 true 时修复不一致之处
+    bool fsck(const bool repair = false)
+    {
+        TRACE_SCOPE("fsck");
+        const auto start_time = chrono::steady_clock::now();
+
+        // 镜像快照：持锁读取整个镜像并覆盖尚未写回的块，此后各线程只读快照，无需加锁
+        vector<char> image(FILESYSTEM_SIZE);
+        {
+            lock_guard<mutex> journal_lock(journal_mutex);
+            _pread(image.data(), 0, FILESYSTEM_SIZE);
+            _overlay_dirty(image.data(), 0, FILESYSTEM_SIZE);
         }
 
-        const INode file_inode = _get_inode(file_inode_id);
+        // 各线程扫描 INode 表中的一段，结果按 INode ID 存放，互不重叠
+        const int thread_num = max(1u, thread::hardware_concurrency());
+        vector<FsckScan> scans(INODE_NUM);
+        vector<future<void>> results;
+        for (int t = 0; t < thread_num; t++)
+            results.push_back(async(launch::async, [&, t]
+                                    {
+                for (int i = INODE_NUM * t / thread_num; i < INODE_NUM * (t + 1) / thread_num; i++)
+                {
+                    FsckScan &scan = scans[i];
+                    memcpy(&scan.inode, &image[INODE_TABLE_START + i * INODE_SIZE], INODE_CLASS_SIZE);
+                    scan.valid = scan.inode.id == i && (scan.inode.file_type == 'f' || scan.inode.file_type == 'd');
+                    if (scan.valid)
+                        _fsck_scan_inode(image.data(), scan);
+                } }));
+        for (auto &result : results)
+            result.get();
+
+        if (!scans[ROOT_INODE_ID].valid || scans[ROOT_INODE_ID].inode.file_type != 'd')
+        {
+            cout << "fsck: root directory inode is corrupted, cannot check" << endl;
+            return false;
+        }
 
-        if (file_inode.file_type == 'f')
+        // 由根目录遍历目录树，统计指向各 INode 的目录项数（含 . 与 ..），. 与 .. 不参与遍历
+        int problem_num = 0;
+        vector<char> reachable(INODE_NUM, 0);
+        vector<int> link_cnt(INODE_NUM, 0);
+        vector<short> pending_dirs = {ROOT_INODE_ID}, dir_order;
+        reachable[ROOT_INODE_ID] = 1;
+        while (!pending_dirs.empty())
         {
-            dout << "[删除文件/目录] 准备删除文件 " << absolute_path << " ..." << endl;
-            _remove(dir_inode_id, file_inode_id);
-            dout << "[删除文件/目录] 文件 " << absolute_path << " 已删除" << endl;
+            const short dir_id = pending_dirs.back();
+            pending_dirs.pop_back();
+            dir_order.push_back(dir_id);
+            for (const auto &dentry : scans[dir_id].dentry_list)
+            {
+                const short target_id = dentry.inode_id;
+                if (target_id < 0 || target_id >= INODE_NUM || !scans[target_id].valid)
+                {
+                    cout << "fsck: entry '" << dentry.filename << "' in directory inode " << dir_id << " refers to invalid inode " << target_id << endl;
+                    problem_num++;
+                    continue;
+                }
+                link_cnt[target_id]++;
+                if (reachable[target_id] || !strcmp(dentry.filename, ".") || !strcmp(dentry.filename, ".."))
+                    continue;
+                reachable[target_id] = 1;
+                if (scans[target_id].inode.file_type == 'd')
+                    pending_dirs.push_back(target_id);
+            }
         }
 
-        else if (file_inode.file_type == 'd')
+        // 可达 INode 引用的块即为在用的块（去重共享的块与尾部打包块会被多次引用）
+        // 只记录是否被引用而不计数：去重共享的引用数可以超过 255，计数会回绕
+        vector<bool> referenced(DATA_BLOCK_NUM, false);
+        int inode_num = 0, dir_num = 0, block_num = 0;
+        for (int i = 0; i < INODE_NUM; i++)
         {
-            if (!recursive)
+            if (!reachable[i])
+                continue;
+            inode_num++;
+            dir_num += scans[i].inode.file_type == 'd';
+            for (const auto &block_id : scans[i].block_list)
             {
-                // cout << "[删除文件/目录] 无法删除目录 " << absolute_path << "，如需删除，请使用 rm -r" << endl;
-                cout << "rm: cannot remove '" << absolute_path << "': Is a directory" << endl;
-                cout << "rm: use 'rm -r' to remove a directory" << endl;
-                return;
+                block_num += !referenced[block_id];
+                referenced[block_id] = true;
             }
-            else if (recursive)
+            for (const auto &block_id : scans[i].invalid_list)
             {
-                dout << "[删除文件/目录] 准备删除目录 " << absolute_path << " ..." << endl;
-                _remove(file_inode_id, -1);
-                dout << "[删除文件/目录] 目录 " << absolute_path << " 已删除" << endl;
+                cout << "fsck: inode " << i << " refers to invalid block " << block_id << endl;
+                problem_num++;
             }
         }
-    }
 
-    void _copy(const short &src_inode_id, const short &dst_dir_inode_id, const string &dst_filename)
-    {
-        // 假设已经完成了一切检查，此函数仅作执行操作
-        const INode src_inode = _get_inode(src_inode_id);
-        dout << "[复制文件/目录] 正在复制文件/目录 " << src_inode_id << " 到目录 " << dst_dir_inode_id << "，目标文件名为 " << dst_filename << " ..." << endl;
-        dout << "[复制文件/目录] 源文件/目录信息：" << endl;
-        dout << src_inode;
-        dout << "[复制文件/目录] 目标目录信息：" << endl;
-        dout << _get_inode(dst_dir_inode_id);
+        // 重新计算子树用量：文件为自身的数据块与地址块（不含尾部打包块），目录再累加各目录项所指的子树，硬链接按目录项分别计入
+        // 目录在遍历顺序中总是排在其子目录之前，逆序累加即可
+        vector<int> subtree_inode_cnt(INODE_NUM, 1), subtree_block_cnt(INODE_NUM, 0);
+        for (int i = 0; i < INODE_NUM; i++)
+            if (reachable[i])
+                subtree_block_cnt[i] = scans[i].block_list.size() - (scans[i].inode.file_type == 'f' && scans[i].inode.tail_block != -1);
+        for (auto it = dir_order.rbegin(); it != dir_order.rend(); it++)
+            for (const auto &dentry : scans[*it].dentry_list)
+            {
+                const short target_id = dentry.inode_id;
+                if (target_id < 0 || target_id >= INODE_NUM || !scans[target_id].valid || !strcmp(dentry.filename, ".") || !strcmp(dentry.filename, ".."))
+                    continue;
+                subtree_inode_cnt[*it] += subtree_inode_cnt[target_id];
+                subtree_block_cnt[*it] += subtree_block_cnt[target_id];
+            }
 
-        if (src_inode.file_type == 'f')
+        // 比对 INode bitmap、链接数、目录项数与子树用量
+        vector<short> inode_fix_list, inode_meta_fix_list;
+        for (int i = 0; i < INODE_NUM; i++)
         {
-            // 新建指定名称的文件
-            short new_inode_id = _create_file(dst_dir_inode_id, dst_filename, src_inode.file_size / 1024);
+            if (reachable[i] != inode_bitmap.get(i))
+            {
+                cout << "fsck: inode " << i << (reachable[i] ? " is in use but marked free" : " is marked used but not reachable from root") << endl;
+                inode_fix_list.push_back(i);
+            }
+            if (!reachable[i])
+                continue;
+            const INode &inode = scans[i].inode;
+            bool meta_mismatch = false;
+            if (inode.link_cnt != link_cnt[i])
+            {
+                cout << "fsck: inode " << i << " link count is " << inode.link_cnt << ", should be " << link_cnt[i] << endl;
+                meta_mismatch = true;
+            }
+            if (inode.file_type == 'd' && inode.dentry_cnt != (int)scans[i].dentry_list.size())
+            {
+                cout << "fsck: directory inode " << i << " entry count is " << inode.dentry_cnt << ", should be " << scans[i].dentry_list.size() << endl;
+                meta_mismatch = true;
+            }
+            if (inode.subtree_inode_cnt != subtree_inode_cnt[i] || inode.subtree_block_cnt != subtree_block_cnt[i])
+            {
+                cout << "fsck: inode " << i << " subtree usage is " << inode.subtree_block_cnt << " blocks and " << inode.subtree_inode_cnt << " inodes, should be "
+                     << subtree_block_cnt[i] << " and " << subtree_inode_cnt[i] << endl;
+                meta_mismatch = true;
+            }
+            if (meta_mismatch)
+                inode_meta_fix_list.push_back(i);
+        }
 
-            // 复制数据块
-            vector<short> src_block_id_list = _get_block_list(src_inode_id);
-            vector<short> dst_block_id_list = _get_block_list(new_inode_id);
-            for (int i = 0; i < src_block_id_list.size(); i++)
+        // 比对块 bitmap
+        vector<short> block_fix_list;
+        for (int i = 0; i < DATA_BLOCK_NUM; i++)
+            if (referenced[i] != block_bitmap.get(i))
             {
-                vector<char> content(BLOCK_SIZE);
-                _load(content.data(), BLOCK_START + src_block_id_list[i] * BLOCK_SIZE, BLOCK_SIZE);
-                _dump(content.data(), BLOCK_START + dst_block_id_list[i] * BLOCK_SIZE, BLOCK_SIZE);
+                cout << "fsck: data block " << i << (referenced[i] ? " is in use but marked free" : " is marked used but not referenced") << endl;
+                block_fix_list.push_back(i);
             }
+
+        // 比对分配组与超级块中的计数（超级块的计数由各分配组汇总而来）
+        vector<array<int, 3>> group_counters(GROUP_NUM, {0, 0, 0});
+        for (int i = 0; i < DATA_BLOCK_NUM; i++)
+            group_counters[_block_group(i)][0] += !referenced[i];
+        for (int i = 0; i < INODE_NUM; i++)
+        {
+            group_counters[_inode_group(i)][1] += !reachable[i];
+            group_counters[_inode_group(i)][2] += reachable[i] && scans[i].inode.file_type == 'd';
         }
-        else if (src_inode.file_type == 'd')
+        int counter_mismatch_num = 0;
+        for (int g = 0; g < GROUP_NUM; g++)
         {
-            dout << "[复制文件/目录] 准备迭代复制目录下的文件/目录 ..." << endl;
+            const array<int, 3> counters = {alloc_groups[g].free_block_num, alloc_groups[g].free_inode_num, alloc_groups[g].dir_num};
+            if (counters == group_counters[g])
+                continue;
+            cout << "fsck: group " << g << " counts " << counters[0] << " free blocks, " << counters[1] << " free inodes, " << counters[2] << " directories, should be "
+                 << group_counters[g][0] << ", " << group_counters[g][1] << ", " << group_counters[g][2] << endl;
+            counter_mismatch_num++;
+        }
+        if (_available_block_num() != DATA_BLOCK_NUM - block_num || _available_inode_num() != INODE_NUM - inode_num)
+        {
+            cout << "fsck: superblock counts " << _available_block_num() << " free blocks and " << _available_inode_num() << " free inodes, should be "
+                 << DATA_BLOCK_NUM - block_num << " and " << INODE_NUM - inode_num << endl;
+            counter_mismatch_num++;
+        }
+        const double elapsed_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count();
 
-            // 新建指定名称的目录
-            short new_inode_id = _create_dir(dst_dir_inode_id, dst_filename);
+        const int fixable_num = inode_fix_list.size() + inode_meta_fix_list.size() + block_fix_list.size() + counter_mismatch_num;
+        problem_num += fixable_num;
+        if (repair && fixable_num > 0)
+        {
+            TransactionScope transaction(*this);
+            // 修复可能增删目录项，硬链接索引之后重新构建
+            link_dirs.clear();
+            link_dirs_ready = false;
+            for (const auto &id : inode_fix_list)
+            {
+                inode_bitmap.set(id, reachable[id]);
+                _dump(&inode_bitmap.bitmap[id / 8], INODE_BITMAP_START + id / 8, 1);
+                dentry_filters.erase(id);
+            }
+            for (const auto &id : inode_meta_fix_list)
+            {
+                INode inode = scans[id].inode;
+                inode.link_cnt = link_cnt[id];
+                inode.subtree_inode_cnt = subtree_inode_cnt[id];
+                inode.subtree_block_cnt = subtree_block_cnt[id];
+                if (inode.file_type == 'd')
+                    inode.dentry_cnt = scans[id].dentry_list.size();
+                _save_inode(inode);
+            }
+            for (const auto &id : block_fix_list)
+            {
+                block_bitmap.set(id, referenced[id]);
+                _dump(&block_bitmap.bitmap[id / 8], BLOCK_BITMAP_START + id / 8, 1);
+            }
+            // 由修正后的 bitmap 与 INode 表重建分配组、尾部打包块与共享块引用数，并写回超级块
+            _init_alloc_groups();
+            _dump_header();
+        }
 
-            // 递归复制源文件夹下的文件
-            vector<Dentry> dentry_list = _load_dentries(src_inode_id);
-            for (const auto &dentry : dentry_list)
-                if (dentry.inode_id != -1 && dentry.get_filename() != "." && dentry.get_filename() != "..")
-                    _copy(dentry.inode_id, new_inode_id, dentry.get_filename());
+        cout << "fsck: checked " << inode_num << " inodes (" << dir_num << " directories) and " << block_num << " blocks with " << thread_num << (thread_num > 1 ? " threads" : " thread") << " in "
+             << fixed << setprecision(1) << elapsed_ms << " ms" << defaultfloat << endl;
+        if (problem_num == 0)
+            cout << "fsck: no problems found" << endl;
+        else if (repair)
+            cout << "fsck: " << problem_num << " problems found, " << fixable_num << " repaired" << endl;
+        else
+            cout << "fsck: " << problem_num << " problems found, run 'fsck -y' to repair" << endl;
+        return problem_num == 0 || (repair && problem_num == fixable_num);
+    }
+
+    void sum()
+    {
+        _sync_superblock_counters();
+        cout << superblock;
+
+        // 尾部打包效率：打包块的字节利用率，以及与每个片段独占一块相比节省的块数
+        int tail_num = 0, tail_byte_num = 0;
+        for (const auto &[block_id, tail_block] : tail_blocks)
+        {
+            tail_num += tail_block.tail_num;
+            tail_byte_num += tail_block.byte_num;
+        }
+        cout << "Tail Blocks:\t\t" << tail_blocks.size() << endl;
+        cout << "Packed Tails:\t\t" << tail_num << " (" << Util::readable_size(tail_byte_num) << ")" << endl;
+        cout << "Tail Packing:\t\t" << fixed << setprecision(1) << (tail_blocks.empty() ? 0.0 : 100.0 * tail_byte_num / (tail_blocks.size() * BLOCK_SIZE)) << "%" << defaultfloat << endl;
+        cout << "Blocks Saved:\t\t" << tail_num - (int)tail_blocks.size() << endl;
+        cout << "------------------------------------------" << endl;
+
+        // 去重后共享的数据块
+        int ref_num = 0;
+        for (const auto &[block_id, refs] : block_refs)
+            ref_num += refs;
+        cout << "Shared Blocks:\t\t" << block_refs.size() << " (" << ref_num << " references)" << endl;
+        cout << "Dedup Saved:\t\t" << ref_num - (int)block_refs.size() << " blocks" << endl;
+        cout << "------------------------------------------" << endl;
+
+        // 压缩效率：压缩文件数据块中的内容大小与实际占用的数据块大小之比
+        int compressed_file_num = 0;
+        int64_t content_size = 0, stored_size = 0;
+        vector<char> inode_table(INODE_TABLE_SIZE);
+        _load(inode_table.data(), INODE_TABLE_START, INODE_TABLE_SIZE);
+        for (int i = 0; i < INODE_NUM; i++)
+        {
+            if (!inode_bitmap.get(i) || !inode_table[i * INODE_SIZE + offsetof(INode, compressed)])
+                continue;
+            INode inode;
+            memcpy(&inode, &inode_table[i * INODE_SIZE], INODE_CLASS_SIZE);
+            compressed_file_num++;
+            content_size += inode.file_size - Util::rest_size(inode.file_size);
+            stored_size += Util::data_block_num(inode.file_size, true) * BLOCK_SIZE;
+        }
+        cout << "Compressed Files:\t" << compressed_file_num << " (" << Util::readable_size(content_size) << " in " << Util::readable_size(stored_size) << ")" << endl;
+        cout << "Compression Ratio:\t" << fixed << setprecision(2) << (stored_size == 0 ? 1.0 : double(content_size) / stored_size) << defaultfloat << endl;
+        cout << "------------------------------------------" << endl;
+        // FileSystem::_show_macros();
+    }
+
+    // 打印 bitmap
+    void _show_bitmap()
+    {
+        dout << "Block Bitmap: " << endl;
+        for (int i = 0; i < BLOCK_BITMAP_SIZE; i++)
+            dout << (int)block_bitmap.bitmap[i];
+        dout << endl;
+
+        vector<short> block_list;
+        for (int i = 0; i < DATA_BLOCK_NUM; i++)
+            if (block_bitmap.get(i))
+                block_list.push_back(i);
+        dout << "已分配的块列表：" << block_list << endl;
+
+        dout << "INode Bitmap:" << endl;
+        for (int i = 0; i < INODE_BITMAP_SIZE; i++)
+            dout << (int)inode_bitmap.bitmap[i];
+        dout << endl;
+
+        vector<short> inode_list;
+        for (int i = 0; i < INODE_NUM; i++)
+            if (inode_bitmap.get(i))
+                inode_list.push_back(i);
+        dout << "已分配的 Inode 列表：" << inode_list << endl;
+    }
+
+    void _vaildate_bitmap_consistency()
+    {
+        // 计算 bitmap 上 1 的总个数
+        int block_bitmap_sum = 0;
+        int inode_bitmap_sum = 0;
+        for (int i = 0; i < DATA_BLOCK_NUM; i++)
+            block_bitmap_sum += block_bitmap.get(i);
+        for (int i = 0; i < INODE_NUM; i++)
+            inode_bitmap_sum += inode_bitmap.get(i);
+
+        dout << "block_bitmap_sum: " << block_bitmap_sum << " " << 516 + block_bitmap_sum << endl;
+        dout << "inode_bitmap_sum: " << inode_bitmap_sum << endl;
+
+        dout << superblock;
+    }
+
+    // 打印所有的宏定义
+    static void _show_macros()
+    {
+        const map<string, int> FILESYS_INFO = {
+            {"FILESYSTEM_SIZE", FILESYSTEM_SIZE},
+            {"BLOCK_SIZE", BLOCK_SIZE},
+            {"INODE_SIZE", INODE_SIZE},
+            {"BLOCK_NUM", BLOCK_NUM},
+            {"INODE_NUM", INODE_NUM},
+            {"MAX_FILE_SIZE", MAX_FILE_SIZE},
+            {"MAX_FILENAME_SIZE", MAX_FILENAME_SIZE},
+            {"DENTRY_SIZE", DENTRY_SIZE},
+            {"DENTRY_NUM_PER_BLOCK", DENTRY_NUM_PER_BLOCK},
+            {"SUPERBLOCK_SIZE", SUPERBLOCK_SIZE},
+            {"BLOCK_BITMAP_SIZE", BLOCK_BITMAP_SIZE},
+            {"INODE_BITMAP_SIZE", INODE_BITMAP_SIZE},
+            {"INODE_TABLE_SIZE", INODE_TABLE_SIZE},
+            {"SUPERBLOCK_START", SUPERBLOCK_START},
+            {"BLOCK_BITMAP_START", BLOCK_BITMAP_START},
+            {"INODE_BITMAP_START", INODE_BITMAP_START},
+            {"INODE_TABLE_START", INODE_TABLE_START},
+            {"BLOCK_START", BLOCK_START},
+            {"DATA_BLOCK_NUM", DATA_BLOCK_NUM},
+            {"ADDRESS_SIZE", ADDRESS_SIZE},
+            {"ADDRESS_PER_BLOCK", ADDRESS_PER_BLOCK},
+            {"NUM_DIRECT_BLOCK", NUM_DIRECT_BLOCK},
+            {"NUM_INDIRECT_BLOCK", NUM_INDIRECT_BLOCK},
+            {"NUM_DOUBLE_INDIRECT_BLOCK", NUM_DOUBLE_INDIRECT_BLOCK},
+            {"ROOT_INODE_ID", ROOT_INODE_ID}};
+
+        // cout << "----------- 文件系统预定义常量 ------------" << endl;
+        cout << "---- Filesystem Predefined Constants ----" << endl;
+        for (const auto &pair : FILESYS_INFO)
+        {
+            Util::cout_center(pair.first, 30);
+            cout << pair.second << endl;
+        }
+        cout << "------------------------------------------" << endl;
+    }
+};
+
+namespace plog
+{
+    class PlainFomatter
+    {
+    public:
+        // This method returns a header for a new file. In our case it is empty.
+        static util::nstring header()
+        {
+            return util::nstring();
+        }
+
+        // This method returns a string from a record.
+        static util::nstring format(const Record &record)
+        {
+            util::nostringstream ss;
+            ss << record.getMessage();
+            return ss.str();
         }
-    }
+    };
+}
 
-    void copy(const string &src_path, const string &dst_path, bool recursive = false)
-    {
-        // 将路径转为绝对路径
-        string absolute_src_path = _absolute_path(src_path);
-        string absolute_dst_path = _absolute_path(dst_path);
+// static plog::ConsoleAppender<plog::MessageOnlyFormatter> consoleAppender;
+// plog::init<Console>(plog::info, &consoleAppender);
 
-        dout << "[复制文件/目录] 准备复制 " << absolute_src_path << " 到 " << absolute_dst_path << " ..." << endl;
+// 命令执行结果
+enum CommandStatus : uint8_t
+{
+    CMD_OK = 0,        // 执行成功
+    CMD_FAILED = 1,    // 文件系统操作失败
+    CMD_USAGE = 2,     // 参数错误
+    CMD_NOT_FOUND = 3, // 未知命令
+    CMD_EXIT = 4,      // 退出
+};
 
-        // 根据路径查找 Inode
-        short src_dir_inode_id, src_file_inode_id;
-        _search_inode(src_path, src_dir_inode_id, src_file_inode_id);
+// 执行一条已分割的命令，交互模式与负载回放共用
+CommandStatus execute_command(FileSystem &fs, vector<string> input_vec)
+{
+    if (input_vec.empty())
+        return CMD_OK;
 
-        short dst_dir_inode_id, dst_file_inode_id;
-        _search_inode(dst_path, dst_dir_inode_id, dst_file_inode_id);
+    CommandStatus status = CMD_OK;
 
-        if (src_file_inode_id == -1)
-        {
-            // cout << "[复制文件/目录] 源文件/目录 " << absolute_src_path << " 不存在" << endl;
-            cout << "cp: cannot copy '" << absolute_src_path << "': No such file or directory" << endl;
-            return;
-        }
+    // 未挂载时只接受格式化镜像与不访问文件系统的命令
+    static const set<string> unmounted_commands = {"mkfs", "erase", "exit", "clear", "cmd"};
+    if (!fs.is_mounted() && !unmounted_commands.count(input_vec[0]))
+    {
+        cout << input_vec[0] << ": no file system mounted, run 'mkfs' or 'erase' to format " << image_path << endl;
+        return CMD_FAILED;
+    }
 
-        const INode src_file_inode = _get_inode(src_file_inode_id);
+    // l / ls
+    if (input_vec[0] == "l" || input_vec[0] == "ls" || input_vec[0] == "dir")
+        status = fs.list_dir() ? CMD_OK : CMD_FAILED;
 
-        if (dst_dir_inode_id == -1)
+    // cd
+    else if (input_vec[0] == "cd" || input_vec[0] == "changeDir")
+    {
+        if (input_vec.size() < 2)
+            ;
+        else if (input_vec.size() > 2)
         {
-            // cout << "[复制文件/目录] 目标路径 " << absolute_dst_path << " 有误" << endl;
-            cout << "cp: cannot copy into '" << absolute_dst_path << "': No such file or directory" << endl;
-            return;
+            cout << "cd: too many arguments" << endl;
+            status = CMD_USAGE;
         }
+        else
+            status = fs.change_dir(input_vec[1]) ? CMD_OK : CMD_FAILED;
+    }
 
-        if (dst_file_inode_id > 0 && _get_inode(dst_file_inode_id).file_type == 'f')
-        {
-            dout << "[复制文件/目录] 目标文件/目录 " << absolute_dst_path << " 已存在，其 INode 如下：" << endl;
-            dout << _get_inode(dst_file_inode_id);
-            cout << "cp: cannot copy into '" << absolute_dst_path << "': File exists" << endl;
-            return;
-        }
+    // sum
+    else if (input_vec[0] == "sum")
+        fs.sum();
 
-        const short src_inode_cnt = inode_cnt(src_file_inode_id);
+    // du
+    else if (input_vec[0] == "du")
+    {
+        if (input_vec.size() == 1)
+            status = fs.disk_usage(fs.working_dir) ? CMD_OK : CMD_FAILED;
+        else
+            for (size_t i = 1; i < input_vec.size(); i++)
+                if (!fs.disk_usage(input_vec[i]))
+                    status = CMD_FAILED;
+    }
+
+    // compact
+    else if (input_vec[0] == "compact")
+    {
+        if (input_vec.size() == 1)
+            status = fs.compact_dir(fs.working_dir) ? CMD_OK : CMD_FAILED;
+        else
+            for (size_t i = 1; i < input_vec.size(); i++)
+                if (!fs.compact_dir(input_vec[i]))
+                    status = CMD_FAILED;
+    }
 
-        if (superblock.available_inode_num < src_inode_cnt)
+    // cat
+    else if (input_vec[0] == "cat")
+    {
+        if (input_vec.size() != 2)
         {
-            dout << "[复制文件/目录] 可用 Inode 不足，复制失败！源文件/目录占用 " << src_inode_cnt << " 个 Inode，目前可用 Inode 剩余 " << superblock.available_inode_num << " 个" << endl;
-            cout << "cp: cannot copy '" << absolute_src_path << "': No available inode" << endl;
-            return;
+            cout << "cat: invalid arguments" << endl
+                 << "Usage: cat [filename]" << endl;
+            status = CMD_USAGE;
         }
+        else
+            status = fs.cat(input_vec[1]) ? CMD_OK : CMD_FAILED;
+    }
 
-        const short src_block_cnt = block_cnt(src_file_inode_id);
-
-        if (superblock.available_block_num < src_block_cnt)
+    // touch
+    else if (input_vec[0] == "touch" || input_vec[0] == "createFile")
+    {
+        if (input_vec.size() != 3)
         {
-            dout << "[复制文件/目录] 可用块不足，复制失败！源文件/目录占用 " << src_block_cnt << " 个块，目前可用块剩余 " << superblock.available_block_num << " 个" << endl;
-            cout << "cp: cannot copy '" << absolute_src_path << "': No available block" << endl;
-            return;
+            cout << input_vec[0] << ": invalid arguments" << endl
+                 << "Usage: touch [filename] [filesize]" << endl;
+            status = CMD_USAGE;
         }
-
-        if (src_file_inode.file_type == 'f')
+        else
         {
-            if (dst_file_inode_id == -1)
+            try
             {
-                dout << "[复制文件/目录] 准备将源文件 " << absolute_src_path << " 复制到目标路径 " << absolute_dst_path << " ..." << endl;
-                _copy(src_file_inode_id, dst_dir_inode_id, _filename(dst_path));
+                const int file_size = Util::parse_size(input_vec[2]);
+                if (file_size < 0)
+                {
+                    cout << input_vec[0] << ": invalid filesize" << endl
+                         << "Usage: touch [filename] [filesize]" << endl;
+                    status = CMD_USAGE;
+                }
+                else
+                    status = fs.create_file(input_vec[1], file_size) ? CMD_OK : CMD_FAILED;
             }
-
-            else if (_get_inode(dst_file_inode_id).file_type == 'd')
+            catch (const exception &e)
             {
-                dout << "[复制文件/目录] 准备将源文件 " << absolute_src_path << " 复制到目标路径 " << absolute_dst_path + "/" + _filename(src_path) << " ..." << endl;
-                _copy(src_file_inode_id, dst_file_inode_id, _filename(src_path));
+                cout << input_vec[0] << ": invalid filesize" << endl
+                     << "Usage: touch [filename] [filesize]" << endl;
+                status = CMD_USAGE;
             }
         }
+    }
 
-        else if (src_file_inode.file_type == 'd')
+    // append / truncate
+    else if (input_vec[0] == "append" || input_vec[0] == "truncate")
+    {
+        if (input_vec.size() != 3)
         {
-            if (!recursive)
-            {
-                // cout << "[复制文件/目录] 无法复制目录 " << absolute_src_path << "，如需复制，请使用 cp -r" << endl;
-                cout << "cp: cannot copy '" << absolute_src_path << "': Is a directory" << endl;
-                cout << "cp: use 'cp -r' to copy a directory" << endl;
-                return;
-            }
-            else if (recursive)
+            cout << input_vec[0] << ": invalid arguments" << endl
+                 << "Usage: " << input_vec[0] << " [filename] [filesize]" << endl;
+            status = CMD_USAGE;
+        }
+        else
+        {
+            try
             {
-                if (dst_file_inode_id == -1)
-                {
-                    dout << "[复制文件/目录] 准备将源文件 " << absolute_src_path << " 复制到目标路径 " << absolute_dst_path << " ..." << endl;
-                    _copy(src_file_inode_id, dst_dir_inode_id, _filename(dst_path));
-                }
-
-                else if (_get_inode(dst_file_inode_id).file_type == 'd')
+                const int file_size = Util::parse_size(input_vec[2]);
+                if (file_size < 0)
                 {
-                    dout << "[复制文件/目录] 准备将源文件 " << absolute_src_path << " 复制到目标路径 " << absolute_dst_path + "/" + _filename(src_path) << " ..." << endl;
-                    _copy(src_file_inode_id, dst_file_inode_id, _filename(src_path));
+                    cout << input_vec[0] << ": invalid filesize" << endl
+                         << "Usage: " << input_vec[0] << " [filename] [filesize]" << endl;
+                    status = CMD_USAGE;
                 }
+                else if (input_vec[0] == "append")
+                    status = fs.append_file(input_vec[1], file_size) ? CMD_OK : CMD_FAILED;
+                else
+                    status = fs.truncate_file(input_vec[1], file_size) ? CMD_OK : CMD_FAILED;
+            }
+            catch (const exception &e)
+            {
+                cout << input_vec[0] << ": invalid filesize" << endl
+                     << "Usage: " << input_vec[0] << " [filename] [filesize]" << endl;
+                status = CMD_USAGE;
             }
         }
-
-        dout << "[复制文件/目录] 文件/目录 " << absolute_src_path << " 已成功复制到 " << absolute_dst_path << endl;
     }
 
-    void hard_link(const string &src_path, const string &dst_path)
+    // mkdir
+    else if (input_vec[0] == "mkdir" || input_vec[0] == "createDir")
     {
-        // 将路径转为绝对路径
-        string absolute_src_path = _absolute_path(src_path);
-        string absolute_dst_path = _absolute_path(dst_path);
-
-        dout << "[硬链接] 准备在 " << absolute_dst_path << " 创建硬链接，指向 " << absolute_src_path << " ..." << endl;
-
-        // 根据路径查找 Inode
-        short src_dir_inode_id, src_file_inode_id;
-        _search_inode(src_path, src_dir_inode_id, src_file_inode_id);
-
-        short dst_dir_inode_id, dst_file_inode_id;
-        _search_inode(dst_path, dst_dir_inode_id, dst_file_inode_id);
-
-        if (src_file_inode_id == -1)
+        if (input_vec.size() < 2)
         {
-            // cout << "[硬链接] 源文件 " << absolute_src_path << " 不存在" << endl;
-            cout << "ln: cannot create link '" << absolute_dst_path << "': No such file or directory" << endl;
-            return;
+            // 可以允许多个 dirname 参数
+            cout << input_vec[0] << ": invalid arguments" << endl
+                 << "Usage: mkdir [dirname1] [dirname2] ..." << endl;
+            status = CMD_USAGE;
         }
+        else
+            for (int i = 1; i < input_vec.size(); i++)
+                if (!fs.create_dir(input_vec[i], 1))
+                    status = CMD_FAILED;
+    }
 
-        if (dst_file_inode_id != -1)
+    // rm
+    else if (input_vec[0] == "rm")
+    {
+        // 允许多个文件/目录参数，能够检测 -r 参数
+        if (input_vec.size() < 2)
         {
-            // cout << "[硬链接] 目标文件 " << absolute_dst_path << " 已存在" << endl;
-            cout << "ln: cannot create link '" << absolute_dst_path << "': File exists" << endl;
-            return;
+            cout << input_vec[0] << ": invalid arguments" << endl
+                 << "Usage: rm [-r] [filename1] [filename2] ..." << endl;
+            status = CMD_USAGE;
         }
+        else
+        {
+            bool recursive = false;
+            for (const auto &input : input_vec)
+                if (input[0] == '-' && input.find("r") != string::npos)
+                {
+                    recursive = true;
+                    input_vec.erase(remove(input_vec.begin(), input_vec.end(), input), input_vec.end());
+                }
 
-        // 创建硬链接（仅新增目录项，不改动 INode 和数据块、地址块）
-        _add_dentry(dst_dir_inode_id, src_file_inode_id, _filename(dst_path));
-        dout << "[硬链接] 硬链接 " << absolute_dst_path << " 已创建" << endl;
+            for (int i = 1; i < input_vec.size(); i++)
+                if (!fs.remove(input_vec[i], recursive))
+                    status = CMD_FAILED;
+        }
     }
 
-    // 读取并打印文件内容
-    void cat(const string &path)
+    // cp
+    else if (input_vec[0] == "cp")
     {
-        // 将路径转为绝对路径
-        string absolute_path = _absolute_path(path);
-
-        // 根据路径查找 Inode
-        short dir_inode_id, file_inode_id;
-        _search_inode(path, dir_inode_id, file_inode_id);
-
-        // 如果 file_inode_id 为 -1，则说明文件不存在
-        if (file_inode_id == -1)
+        // 允许多个文件/目录参数，能够检测 -r 参数
+        if (input_vec.size() < 3)
         {
-            // cout << "[查看文件内容] 文件 " << absolute_path << " 不存在" << endl;
-            cout << "cat: " << absolute_path << ": No such file or directory" << endl;
-            return;
+            cout << input_vec[0] << ": invalid arguments" << endl
+                 << "Usage: cp [-r] [src] [dst]" << endl;
+            status = CMD_USAGE;
         }
-
-        // 获取文件 INode
-        INode file_inode = _get_inode(file_inode_id);
-
-        // 如果不是文件
-        if (file_inode.file_type != 'f')
+        else
         {
-            // cout << "[查看文件内容] " << absolute_path << " 不是文件" << endl;
-            cout << "cat: " << absolute_path << ": Is a directory" << endl;
-            return;
-        }
+            bool recursive = false;
+            for (const auto &input : input_vec)
+                // if (input[0] == '-' && boost::algorithm::contains(input, "r"))
+                if (input[0] == '-' && input.find("r") != string::npos)
+                {
+                    recursive = true;
+                    input_vec.erase(remove(input_vec.begin(), input_vec.end(), input), input_vec.end());
+                }
 
-        // 读取文件内容
-        string content = _load_file(file_inode);
-        // cout << "[查看文件内容] 文件 " << absolute_path << " 内容如下：" << endl;
-        cout << content << endl;
-        // cout << "-------------------------" << endl;
+            status = fs.copy(input_vec[1], input_vec[2], recursive) ? CMD_OK : CMD_FAILED;
+        }
     }
 
-    // 改变当前工作目录
-    void change_dir(string path)
+    // mv
+    else if (input_vec[0] == "mv")
     {
-        // 将路径转为绝对路径
-        string absolute_path = _absolute_path(path);
-
-        if (absolute_path.empty())
+        if (input_vec.size() != 3)
         {
-            // cout << "[切换工作目录] 路径 " << path << " 不合法" << endl;
-            cout << "cd: invalid path" << endl;
-            return;
+            cout << input_vec[0] << ": invalid arguments" << endl
+                 << "Usage: mv [src] [dst]" << endl;
+            status = CMD_USAGE;
         }
+        else
+            status = fs.rename(input_vec[1], input_vec[2]) ? CMD_OK : CMD_FAILED;
+    }
 
-        // 根据路径查找 Inode
-        short dir_inode_id, file_inode_id;
-        _search_inode(path, dir_inode_id, file_inode_id);
-        short _inode_id = file_inode_id;
-
-        // 如果 dir_inode_id 为 -1，则说明目录不存在
-        if (_inode_id == -1)
+    // ln
+    else if (input_vec[0] == "ln")
+    {
+        if (input_vec.size() != 3)
         {
-            // cout << "[切换工作目录] " << absolute_path << " 不存在" << endl;
-            cout << "cd: " << absolute_path << ": No such file or directory" << endl;
-            return;
+            cout << input_vec[0] << ": invalid arguments" << endl
+                 << "Usage: ln [src] [dst]" << endl;
+            status = CMD_USAGE;
         }
         else
-        {
-            INode dir_inode = _get_inode(_inode_id);
-            if (dir_inode.file_type != 'd')
-            {
-                // cout << "[切换工作目录] " << absolute_path << " 不是目录" << endl;
-                cout << "cd: " << absolute_path << ": Not a directory" << endl;
-                return;
-            }
-            else
-            {
-                dout << "[切换工作目录] 当前工作目录：" << working_dir << " -> " << absolute_path << endl;
-                working_dir = absolute_path;
-                working_dir_inode_id = _inode_id;
-            }
-        }
+            status = fs.hard_link(input_vec[1], input_vec[2]) ? CMD_OK : CMD_FAILED;
     }
 
-    void list_dir(string path = "")
+    // stat
+    else if (input_vec[0] == "stat")
     {
-        short _inode_id, dir_inode_id;
-
-        // 将路径转为绝对路径
-        string absolute_path = _absolute_path(path);
-
-        if (path.empty())
-            _inode_id = working_dir_inode_id;
-        else if (path == "/")
-            _inode_id = ROOT_INODE_ID;
-        else
-            _search_inode(path, dir_inode_id, _inode_id);
-
-        // 如果 dir_inode_id 为 -1，则说明目录不存在
-        if (_inode_id == -1)
+        if (input_vec.size() != 2)
         {
-            // cout << "[列出目录] " << absolute_path << " 不存在" << endl;
-            cout << "ls: cannot access '" << absolute_path << "': No such file or directory" << endl;
-            return;
+            cout << input_vec[0] << ": invalid arguments" << endl
+                 << "Usage: stat [filename]" << endl;
+            status = CMD_USAGE;
         }
         else
-        {
-            INode _inode = _get_inode(_inode_id);
-            if (_inode.file_type != 'd')
-            {
-                // cout << "[列出目录] " << absolute_path << " 不是目录" << endl;
-                cout << "ls: cannot access '" << absolute_path << "': Not a directory" << endl;
-                return;
-            }
-            else
-            {
-                vector<Dentry> dentry_list = _load_dentries(_inode);
-                // cout << "[列出目录] 目录 " << absolute_path << " 内容如下：" << endl;
-                for (const auto &dentry : dentry_list)
-                {
-                    if (dentry.inode_id != -1)
-                    {
-                        INode inode = _get_inode(dentry.inode_id);
-                        // cout << setw(4) << inode.id << "  ";
-                        if (inode.file_type == 'd')
-                            // cout << "目录 ";
-                            cout << " dir ";
-                        else if (inode.file_type == 'f')
-                            // cout << "文件 ";
-                            cout << "file ";
-                        else
-                            // cout << "未知 ";
-                            cout << "unkn ";
-                        cout << setw(2) << inode.link_cnt << "  ";
-                        cout << setw(4) << Util::readable_size(inode.file_size) << "  ";
-                        cout << Util::time_to_string(inode.create_time) << " ";
-                        cout << Util::time_to_string(inode.modify_time) << "  ";
-                        // 文件名
-                        if (inode.file_type == 'd')
-                            cout << BOLD << BLUE << dentry.get_filename() << RESET << endl;
-                        else
-                            cout << dentry.get_filename() << endl;
-                    }
-                }
-                // cout << "------------------------------------------" << endl;
+            status = fs.stat(input_vec[1]) ? CMD_OK : CMD_FAILED;
+    }
+
+    // sum
+    else if (input_vec[0] == "sum")
+        fs.sum();
+
+    // sync
+    else if (input_vec[0] == "sync")
+        fs.sync();
+
+    // dedup
+    else if (input_vec[0] == "dedup")
+        fs.dedup();
+
+    // write
+    else if (input_vec[0] == "write")
+    {
+        if (input_vec.size() != 4)
+        {
+            cout << "write: invalid arguments" << endl
+                 << "Usage: write [filename] [offset] [content]" << endl;
+            status = CMD_USAGE;
+        }
+        else
+        {
+            try
+            {
+                status = fs.write_file(input_vec[1], stoi(input_vec[2]), input_vec[3]) ? CMD_OK : CMD_FAILED;
+            }
+            catch (const exception &e)
+            {
+                cout << "write: invalid offset" << endl
+                     << "Usage: write [filename] [offset] [content]" << endl;
+                status = CMD_USAGE;
             }
         }
     }
 
-    void stat(const string &path)
-    {
-        // 将路径转为绝对路径
-        string absolute_path = _absolute_path(path);
+    // stats
+    else if (input_vec[0] == "stats")
+        fs.stats();
 
-        // 根据路径查找 Inode
-        short dir_inode_id, file_inode_id;
-        _search_inode(path, dir_inode_id, file_inode_id);
+    // scrub
+    else if (input_vec[0] == "scrub")
+        fs.scrub();
 
-        // 如果 file_inode_id 为 -1，则说明文件不存在
-        if (file_inode_id == -1)
+    // trim
+    else if (input_vec[0] == "trim")
+        status = fs.trim() ? CMD_OK : CMD_FAILED;
+
+    // fsck
+    else if (input_vec[0] == "fsck")
+    {
+        if (input_vec.size() == 1 || (input_vec.size() == 2 && input_vec[1] == "-y"))
+            status = fs.fsck(input_vec.size() == 2) ? CMD_OK : CMD_FAILED;
+        else
         {
-            // cout << "[查看文件状态] 文件 " << absolute_path << " 不存在" << endl;
-            cout << "stat: cannot stat '" << absolute_path << "': No such file or directory" << endl;
-            return;
+            cout << "Usage: fsck [-y]" << endl;
+            status = CMD_USAGE;
         }
+    }
 
-        // 打印 INode 信息
-        cout << "File: " << absolute_path << endl;
-        cout << _get_inode(file_inode_id);
+    // trace
+    else if (input_vec[0] == "trace")
+    {
+        if (input_vec.size() == 2 && input_vec[1] == "on")
+        {
+            Tracer::enable();
+            Tracer::dump_at_exit("trace.json");
+            cout << "[Trace] Tracing enabled, events will be written to trace.json on exit" << endl;
+        }
+        else if (input_vec.size() == 2 && input_vec[1] == "off")
+        {
+            Tracer::enable(false);
+            cout << "[Trace] Tracing disabled" << endl;
+        }
+        else if ((input_vec.size() == 2 || input_vec.size() == 3) && input_vec[1] == "dump")
+        {
+            string path = input_vec.size() == 3 ? input_vec[2] : "trace.json";
+            int event_num = Tracer::dump(path);
+            if (event_num < 0)
+            {
+                cout << "trace: cannot write '" << path << "'" << endl;
+                status = CMD_FAILED;
+            }
+            else
+                cout << "[Trace] " << event_num << " events written to " << path << endl;
+        }
+        else
+        {
+            cout << input_vec[0] << ": invalid arguments" << endl
+                 << "Usage: trace [on|off|dump [path]]" << endl;
+            status = CMD_USAGE;
+        }
     }
 
-    void sum()
+    // bitmap / bm
+    else if (input_vec[0] == "bitmap" || input_vec[0] == "bm")
+        fs._show_bitmap();
+
+    // exit
+    else if (input_vec[0] == "exit")
+        status = CMD_EXIT;
+
+    else if (input_vec[0] == "clear")
+        system("clear");
+
+    // erase
+    else if (input_vec[0] == "erase")
     {
-        cout << superblock;
-        // FileSystem::_show_macros();
+        if (fs.format(geometry))
+            cout << "[Erase] Filesystem erased" << endl;
+        else
+            status = CMD_FAILED;
     }
 
-    // 打印 bitmap
-    void _show_bitmap()
+    // mkfs
+    else if (input_vec[0] == "mkfs")
     {
-        dout << "Block Bitmap: " << endl;
-        for (int i = 0; i < BLOCK_BITMAP_SIZE; i++)
-            dout << (int)block_bitmap.bitmap[i];
-        dout << endl;
+        if (input_vec.size() > 4)
+        {
+            cout << "Usage: mkfs [image size] [block size] [bytes per inode]" << endl;
+            status = CMD_USAGE;
+        }
+        else
+        {
+            try
+            {
+                const Geometry default_geometry;
+                const int filesystem_size = input_vec.size() > 1 ? Util::parse_size(input_vec[1]) : default_geometry.filesystem_size;
+                const int block_size = input_vec.size() > 2 ? Util::parse_size(input_vec[2]) : default_geometry.block_size;
+                const int bytes_per_inode = input_vec.size() > 3 ? Util::parse_size(input_vec[3]) : 0;
+                if (bytes_per_inode == 0 && input_vec.size() > 3)
+                    throw invalid_argument("zero bytes per inode");
+                status = fs.mkfs(filesystem_size, block_size, bytes_per_inode) ? CMD_OK : CMD_FAILED;
+            }
+            catch (const exception &e)
+            {
+                cout << "mkfs: invalid size" << endl
+                     << "Usage: mkfs [image size] [block size] [bytes per inode]" << endl;
+                status = CMD_USAGE;
+            }
+        }
+    }
 
-        vector<short> block_list;
-        for (int i = 0; i < DATA_BLOCK_NUM; i++)
-            if (block_bitmap.get(i))
-                block_list.push_back(i);
-        dout << "已分配的块列表：" << block_list << endl;
+    // cmd
+    else if (input_vec[0] == "cmd")
+    {
+        cout << "Available commands:" << endl;
+        cout << "\tl / ls" << endl
+             << "\t\tList files in current directory" << endl;
+        cout << "\tcd [path]" << endl
+             << "\t\tChange working directory" << endl;
+        cout << "\tsum" << endl
+             << "\t\tShow filesystem summary" << endl;
+        cout << "\tdu [path1] [path2] ..." << endl
+             << "\t\tShow space used by a file or directory tree" << endl;
+        cout << "\tcompact [dir1] [dir2] ..." << endl
+             << "\t\tPack directory entries and free empty dentry blocks" << endl;
+        cout << "\tcat [filename]" << endl
+             << "\t\tShow file content" << endl;
+        cout << "\twrite [filename] [offset] [content]" << endl
+             << "\t\tOverwrite file content at a byte offset" << endl;
+        cout << "\ttouch [filename] [filesize]" << endl
+             << "\t\tCreate a file (size in KB, or in bytes with a B suffix, e.g. 100B)" << endl;
+        cout << "\tappend [filename] [filesize]" << endl
+             << "\t\tAppend random content to a file" << endl;
+        cout << "\ttruncate [filename] [filesize]" << endl
+             << "\t\tShrink or extend a file to the given size" << endl;
+        cout << "\tmkdir [dirname1] [dirname2] ..." << endl
+             << "\t\tCreate a directory" << endl;
+        cout << "\trm [-r] [filename1] [filename2] ..." << endl
+             << "\t\tRemove a file or directory" << endl;
+        cout << "\tcp [-r] [src] [dst]" << endl
+             << "\t\tCopy a file or directory" << endl;
+        cout << "\tmv [src] [dst]" << endl
+             << "\t\tMove or rename a file or directory" << endl;
+        cout << "\tln [src] [dst]" << endl
+             << "\t\tCreate a hard link" << endl;
+        cout << "\tstat [filename]" << endl
+             << "\t\tShow file INode info" << endl;
+        cout << "\tsum" << endl
+             << "\t\tShow filesystem summary" << endl;
+        cout << "\tsync" << endl
+             << "\t\tWrite back all dirty blocks and wait until durable" << endl;
+        cout << "\tstats" << endl
+             << "\t\tShow writeback queue depth and bytes written" << endl;
+        cout << "\tscrub" << endl
+             << "\t\tVerify the checksum of every block in the image" << endl;
+        cout << "\ttrim" << endl
+             << "\t\tPunch holes in the image for all free blocks" << endl;
+        cout << "\tfsck [-y]" << endl
+             << "\t\tCheck bitmaps, link counts and counters against the directory tree, -y to repair" << endl;
+        cout << "\tdedup" << endl
+             << "\t\tShare identical data blocks between files and report space reclaimed" << endl;
+        cout << "\ttrace [on|off|dump [path]]" << endl
+             << "\t\tRecord operation spans as Chrome trace JSON" << endl;
+        cout << "\tclear" << endl
+             << "\t\tClear screen" << endl;
+        cout << "\terase" << endl
+             << "\t\tErase filesystem" << endl;
+        cout << "\tmkfs [image size] [block size] [bytes per inode]" << endl
+             << "\t\tReformat with a new geometry (default 16M 1K 2K)" << endl;
+        cout << "\texit" << endl
+             << "\t\tExit" << endl;
+    }
 
-        dout << "INode Bitmap:" << endl;
-        for (int i = 0; i < INODE_BITMAP_SIZE; i++)
-            dout << (int)inode_bitmap.bitmap[i];
-        dout << endl;
+    else if (input_vec[0] == "")
+        ;
 
-        vector<short> inode_list;
-        for (int i = 0; i < INODE_NUM; i++)
-            if (inode_bitmap.get(i))
-                inode_list.push_back(i);
-        dout << "已分配的 Inode 列表：" << inode_list << endl;
+    else
+    {
+        cout << "command not found: " << input_vec[0] << endl
+             << "Type 'cmd' to see all available commands" << endl;
+        status = CMD_NOT_FOUND;
     }
 
-    void _vaildate_bitmap_consistency()
+    return status;
+}
+
+// 负载记录：将每条命令及其时间戳、耗时、执行结果追加到紧凑的二进制文件
+// 文件格式：魔数 "FSWL" + 版本（1 Byte） + 起始时间（8 Byte，Unix 微秒），之后为若干条记录：
+//   varint 距上一条命令开始的微秒数 | varint 耗时微秒数 | 结果状态（1 Byte） | varint 命令长度 | 命令文本
+class WorkloadRecorder
+{
+public:
+    static constexpr char MAGIC[4] = {'F', 'S', 'W', 'L'};
+    static constexpr uint8_t VERSION = 1;
+
+    bool open(const string &path)
     {
-        // 计算 bitmap 上 1 的总个数
-        int block_bitmap_sum = 0;
-        int inode_bitmap_sum = 0;
-        for (int i = 0; i < DATA_BLOCK_NUM; i++)
-            block_bitmap_sum += block_bitmap.get(i);
-        for (int i = 0; i < INODE_NUM; i++)
-            inode_bitmap_sum += inode_bitmap.get(i);
+        file.open(path, ios::out | ios::binary | ios::trunc);
+        if (!file)
+            return false;
 
-        dout << "block_bitmap_sum: " << block_bitmap_sum << " " << 516 + block_bitmap_sum << endl;
-        dout << "inode_bitmap_sum: " << inode_bitmap_sum << endl;
+        int64_t start_us = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        file.write(MAGIC, sizeof(MAGIC));
+        file.put(VERSION);
+        file.write((char *)&start_us, sizeof(start_us));
+        file.flush();
+        last_start = chrono::steady_clock::now();
+        return true;
+    }
 
-        dout << superblock;
+    bool is_open() const
+    {
+        return file.is_open();
     }
 
-    // 打印所有的宏定义
-    static void _show_macros()
+    void append(const chrono::steady_clock::time_point &start, const chrono::steady_clock::time_point &end, CommandStatus status, const string &command)
     {
-        const map<string, int> FILESYS_INFO = {
-            {"FILESYSTEM_SIZE", FILESYSTEM_SIZE},
-            {"BLOCK_SIZE", BLOCK_SIZE},
-            {"INODE_SIZE", INODE_SIZE},
-            {"BLOCK_NUM", BLOCK_NUM},
-            {"INODE_NUM", INODE_NUM},
-            {"MAX_FILE_SIZE", MAX_FILE_SIZE},
-            {"MAX_FILENAME_SIZE", MAX_FILENAME_SIZE},
-            {"DENTRY_SIZE", DENTRY_SIZE},
-            {"DENTRY_NUM_PER_BLOCK", DENTRY_NUM_PER_BLOCK},
-            {"SUPERBLOCK_SIZE", SUPERBLOCK_SIZE},
-            {"BLOCK_BITMAP_SIZE", BLOCK_BITMAP_SIZE},
-            {"INODE_BITMAP_SIZE", INODE_BITMAP_SIZE},
-            {"INODE_TABLE_SIZE", INODE_TABLE_SIZE},
-            {"SUPERBLOCK_START", SUPERBLOCK_START},
-            {"BLOCK_BITMAP_START", BLOCK_BITMAP_START},
-            {"INODE_BITMAP_START", INODE_BITMAP_START},
-            {"INODE_TABLE_START", INODE_TABLE_START},
-            {"BLOCK_START", BLOCK_START},
-            {"DATA_BLOCK_NUM", DATA_BLOCK_NUM},
-            {"ADDRESS_SIZE", ADDRESS_SIZE},
-            {"ADDRESS_PER_BLOCK", ADDRESS_PER_BLOCK},
-            {"NUM_DIRECT_BLOCK", NUM_DIRECT_BLOCK},
-            {"NUM_INDIRECT_BLOCK", NUM_INDIRECT_BLOCK},
-            {"NUM_DOUBLE_INDIRECT_BLOCK", NUM_DOUBLE_INDIRECT_BLOCK},
-            {"ROOT_INODE_ID", ROOT_INODE_ID}};
+        _write_varint(chrono::duration_cast<chrono::microseconds>(start - last_start).count());
+        _write_varint(chrono::duration_cast<chrono::microseconds>(end - start).count());
+        file.put(status);
+        _write_varint(command.size());
+        file.write(command.data(), command.size());
+        // 每条命令落盘，进程被中断时也能保留完整记录
+        file.flush();
+        last_start = start;
+    }
 
-        // cout << "----------- 文件系统预定义常量 ------------" << endl;
-        cout << "---- Filesystem Predefined Constants ----" << endl;
-        for (const auto &pair : FILESYS_INFO)
+private:
+    ofstream file;
+    chrono::steady_clock::time_point last_start;
+
+    void _write_varint(uint64_t value)
+    {
+        while (value >= 0x80)
         {
-            Util::cout_center(pair.first, 30);
-            cout << pair.second << endl;
+            file.put(char(value | 0x80));
+            value >>= 7;
         }
-        cout << "------------------------------------------" << endl;
+        file.put(char(value));
     }
 };
 
-namespace plog
+// 负载回放：复用 execute_command 重新执行记录的命令，统计每类操作的耗时
+class WorkloadReplayer
 {
-    class PlainFomatter
+public:
+    struct Record
     {
-    public:
-        // This method returns a header for a new file. In our case it is empty.
-        static util::nstring header()
+        int64_t offset_us;  // 相对于第一条命令的开始时间
+        int64_t latency_us; // 记录时的耗时
+        CommandStatus status;
+        string command;
+    };
+
+    static bool load(const string &path, vector<Record> &records)
+    {
+        ifstream file(path, ios::in | ios::binary);
+        if (!file)
+            return false;
+
+        char magic[4];
+        int64_t start_us;
+        file.read(magic, sizeof(magic));
+        uint8_t version = file.get();
+        file.read((char *)&start_us, sizeof(start_us));
+        if (!file || memcmp(magic, WorkloadRecorder::MAGIC, sizeof(magic)) != 0 || version != WorkloadRecorder::VERSION)
+            return false;
+
+        int64_t offset_us = 0;
+        uint64_t delta_us, latency_us, length;
+        while (_read_varint(file, delta_us) && _read_varint(file, latency_us))
         {
-            return util::nstring();
+            int status = file.get();
+            if (status == EOF || !_read_varint(file, length))
+                break;
+            string command(length, '\0');
+            if (!file.read(command.data(), length))
+                break;
+            offset_us = records.empty() ? 0 : offset_us + delta_us;
+            records.push_back({offset_us, int64_t(latency_us), CommandStatus(status), command});
         }
+        return true;
+    }
 
-        // This method returns a string from a record.
-        static util::nstring format(const Record &record)
+    // paced 为 true 时按记录中的时间间隔执行，否则尽可能快地执行
+    static void replay(FileSystem &fs, const vector<Record> &records, bool paced)
+    {
+        struct OpStat
         {
-            util::nostringstream ss;
-            ss << record.getMessage();
-            return ss.str();
+            vector<int64_t> latency_us;
+            int64_t recorded_us = 0;
+            int status_mismatch = 0;
+        };
+        map<string, OpStat> op_stats;
+
+        // 回放期间屏蔽命令输出，只保留统计结果
+        streambuf *cout_sbuf = cout.rdbuf();
+        ofstream devnull("/dev/null");
+        cout.rdbuf(devnull.rdbuf());
+
+        const auto replay_start = chrono::steady_clock::now();
+        for (const auto &record : records)
+        {
+            if (paced)
+                this_thread::sleep_until(replay_start + chrono::microseconds(record.offset_us));
+
+            vector<string> input_vec = Util::split_space(record.command);
+            const auto start = chrono::steady_clock::now();
+            CommandStatus status = execute_command(fs, input_vec);
+            const auto end = chrono::steady_clock::now();
+
+            OpStat &op_stat = op_stats[input_vec.empty() ? "" : input_vec[0]];
+            op_stat.latency_us.push_back(chrono::duration_cast<chrono::microseconds>(end - start).count());
+            op_stat.recorded_us += record.latency_us;
+            if (status != record.status)
+                op_stat.status_mismatch++;
         }
-    };
-}
+        const auto replay_end = chrono::steady_clock::now();
+
+        cout.rdbuf(cout_sbuf);
+
+        double total_ms = chrono::duration_cast<chrono::microseconds>(replay_end - replay_start).count() / 1000.0;
+        cout << "------------------------------ Replay Report ------------------------------" << endl;
+        cout << "Commands:\t" << records.size() << (paced ? " (paced)" : " (as fast as possible)") << endl;
+        cout << "Total Time:\t" << fixed << setprecision(3) << total_ms << " ms" << endl;
+        if (total_ms > 0)
+            cout << "Throughput:\t" << fixed << setprecision(1) << records.size() / total_ms * 1000 << " ops/s" << endl;
+        cout << "---------------------------------------------------------------------------" << endl;
+        cout << left << setw(10) << "op" << right << setw(8) << "count" << setw(12) << "mean(us)" << setw(12) << "p50(us)" << setw(12) << "p99(us)" << setw(12) << "max(us)" << setw(12) << "rec(us)" << setw(8) << "diff" << endl;
+        for (auto &[op, op_stat] : op_stats)
+        {
+            vector<int64_t> &latency_us = op_stat.latency_us;
+            sort(latency_us.begin(), latency_us.end());
+            int64_t total_us = 0;
+            for (const auto &us : latency_us)
+                total_us += us;
+            const int64_t count = latency_us.size();
+            cout << left << setw(10) << op << right << setw(8) << count
+                 << setw(12) << total_us / count
+                 << setw(12) << latency_us[(count - 1) / 2]
+                 << setw(12) << latency_us[(count - 1) * 99 / 100]
+                 << setw(12) << latency_us.back()
+                 << setw(12) << op_stat.recorded_us / count
+                 << setw(8) << op_stat.status_mismatch << endl;
+        }
+        cout << "---------------------------------------------------------------------------" << endl;
+        cout << "rec: mean latency when recorded; diff: commands whose status differs from the recording" << endl;
+    }
 
-// static plog::ConsoleAppender<plog::MessageOnlyFormatter> consoleAppender;
-// plog::init<Console>(plog::info, &consoleAppender);
+private:
+    static bool _read_varint(ifstream &file, uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            int byte = file.get();
+            if (byte == EOF)
+                return false;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+};
+
+// Ctrl+C 只置位标志，由主循环在命令之间正常退出：处理函数中直接 exit 可能在持有 journal_mutex 时析构文件系统而死锁
+volatile sig_atomic_t sigint_captured = 0;
 
 int main(int argc, char *argv[])
 {
-    system("clear");
+    string record_path, replay_path, snapshot_path;
+    bool paced = false, fresh = false, custom_image = false;
+    int flush_interval_ms = FLUSH_INTERVAL_MS, flush_dirty_threshold = FLUSH_DIRTY_THRESHOLD;
+    bool sync_io = false, compress = false;
 
-    if (argc > 1)
+    for (int i = 1; i < argc; i++)
     {
-        string param = string(argv[1]);
+        string param = string(argv[i]);
         if (param == "d" || param == "debug")
         {
             static plog::ConsoleAppender<plog::PlainFomatter> consoleAppender;
@@ -2183,10 +6749,78 @@ int main(int argc, char *argv[])
             // static plog::RollingFileAppender<plog::PlainFomatter> fileAppender("main.log");
             // plog::init(plog::debug, &fileAppender);
         }
+        // 开启操作追踪，退出时导出到 trace.json
+        else if (param == "t" || param == "trace")
+        {
+            Tracer::enable();
+            Tracer::dump_at_exit("trace.json");
+        }
+        // 记录本次会话的命令：record [trace_path]
+        else if (param == "record")
+            record_path = i + 1 < argc ? argv[++i] : "workload.bin";
+        // 回放记录的命令：replay [trace_path] [paced] [fresh | snapshot snapshot_path]，在独立的镜像上进行，不改动 file.sys
+        else if (param == "replay")
+            replay_path = i + 1 < argc ? argv[++i] : "workload.bin";
+        else if (param == "paced")
+            paced = true;
+        else if (param == "fresh")
+            fresh = true;
+        else if (param == "snapshot" && i + 1 < argc)
+            snapshot_path = argv[++i];
+        // 使用指定的镜像文件代替 file.sys：image [path]
+        else if (param == "image" && i + 1 < argc)
+        {
+            image_path = argv[++i];
+            custom_image = true;
+        }
+        // 后台回写参数：interval [ms] 为唤醒间隔，dirty [kb] 为立即回写的脏块阈值
+        else if (param == "interval" && i + 1 < argc)
+            flush_interval_ms = max(1, atoi(argv[++i]));
+        else if (param == "dirty" && i + 1 < argc)
+            flush_dirty_threshold = max(1, atoi(argv[++i])) * 1024;
+        // 不使用 io_uring，全部读写走同步 I/O
+        else if (param == "syncio")
+            sync_io = true;
+        // 新建的文件压缩存放
+        else if (param == "compress")
+            compress = true;
+    }
+
+    vector<WorkloadReplayer::Record> records;
+    if (!replay_path.empty())
+    {
+        if (!WorkloadReplayer::load(replay_path, records))
+        {
+            cout << "replay: cannot read workload '" << replay_path << "'" << endl;
+            return 1;
+        }
+
+        // 未指定镜像时在临时镜像上回放，退出时删除（须在文件系统构造前注册，才会在其析构之后执行）；
+        // 临时镜像的初始内容取自快照、全新创建或复制当前的 file.sys
+        error_code ec;
+        const string source_path = snapshot_path.empty() ? image_path : snapshot_path;
+        if (!custom_image)
+        {
+            image_path = (filesystem::temp_directory_path() / ("filesys-replay-" + to_string(getpid()) + ".sys")).string();
+            atexit([]
+                   { error_code ec;
+                     filesystem::remove(image_path, ec); });
+        }
+        if (fresh)
+            filesystem::remove(image_path, ec);
+        else if ((!snapshot_path.empty() || (!custom_image && filesystem::exists(source_path))) &&
+                 !filesystem::copy_file(source_path, image_path, filesystem::copy_options::overwrite_existing, ec))
+        {
+            cout << "replay: cannot copy '" << source_path << "' to '" << image_path << "': " << ec.message() << endl;
+            return 1;
+        }
     }
+    else
+    {
+        system("clear");
 
-    // 欢迎界面
-    cout << R"(
+        // 欢迎界面
+        cout << R"(
 
     ███████     █████████      JIANG Ying-Jin（江英进）
   ███░░░░░███  ███░░░░░███         202130430089     
@@ -2210,36 +6844,66 @@ int main(int argc, char *argv[])
   Advised by Prof. ZHONG Jinghui     ░░░░░░             
 
     )" << endl;
+    }
 
     // 初始化文件系统
     static FileSystem fs;
+    if (sync_io)
+        fs.disable_async_io();
+    if (compress)
+        fs.enable_compression();
+    fs.start_flusher(flush_interval_ms, flush_dirty_threshold);
+
+    if (!replay_path.empty())
+    {
+        WorkloadReplayer::replay(fs, records, paced);
+        return 0;
+    }
+
+    static WorkloadRecorder recorder;
+    if (!record_path.empty())
+    {
+        if (recorder.open(record_path))
+            cout << "[Record] Recording commands to " << record_path << endl;
+        else
+            cout << "record: cannot write '" << record_path << "'" << endl;
+    }
 
     string user_input;
     vector<string> input_vec;
 
-    // 注册 Ctrl+C 信号处理函数
-    signal(SIGINT, [](int sig_num)
-           {
-        cout << endl << "SIGINT captured. Exiting gracefully." << endl;
-        exit(0); });
+    // 注册 Ctrl+C 信号处理函数，不设 SA_RESTART，使阻塞中的 getline 被中断返回
+    struct sigaction sigint_action = {};
+    sigint_action.sa_handler = [](int sig_num)
+    { sigint_captured = 1; };
+    sigemptyset(&sigint_action.sa_mask);
+    sigaction(SIGINT, &sigint_action, nullptr);
 
     // 处理 Docker 非 -it 模式下的关闭标准输入问题
     char *term_val = getenv("TERM");
     if (term_val == nullptr)
     {
         cout << "Docker non-interactive mode detected. Please run with -it option." << endl;
-        // 无限等待
-        std::mutex mtx;
-        std::condition_variable cv;
-        std::unique_lock<std::mutex> lock(mtx);
-        cv.wait(lock);
+        // 等待 Ctrl+C
+        while (!sigint_captured)
+            pause();
+        cout << endl << "SIGINT captured. Exiting gracefully." << endl;
         return 0;
     }
 
     while (true)
     {
-        cout << BOLD << CYAN << fs.working_dir << GREEN << " > " << RESET;
-        getline(cin, user_input);
+        // 命令执行期间收到的 Ctrl+C 在命令完成后处理
+        if (!sigint_captured)
+        {
+            cout << BOLD << CYAN << fs.working_dir << GREEN << " > " << RESET;
+            getline(cin, user_input);
+        }
+        if (sigint_captured)
+        {
+            cout << endl << "SIGINT captured. Exiting gracefully." << endl;
+            break;
+        }
 
         // 去除前后空格并分割
         user_input = Util::trim_space(user_input);
@@ -2249,211 +6913,19 @@ int main(int argc, char *argv[])
 
         dout << "用户输入：" << user_input << "，分割结果：" << input_vec << "，长度：" << input_vec.size() << "，为空：" << input_vec.empty() << endl;
 
-        if (!input_vec.empty())
-        {
-            // l / ls
-            if (input_vec[0] == "l" || input_vec[0] == "ls" || input_vec[0] == "dir")
-                fs.list_dir();
-
-            // cd
-            else if (input_vec[0] == "cd" || input_vec[0] == "changeDir")
-            {
-                if (input_vec.size() < 2)
-                    ;
-                else if (input_vec.size() > 2)
-                    cout << "cd: too many arguments" << endl;
-                else
-                    fs.change_dir(input_vec[1]);
-            }
-
-            // sum
-            else if (input_vec[0] == "sum")
-                fs.sum();
-
-            // cat
-            else if (input_vec[0] == "cat")
-            {
-                if (input_vec.size() != 2)
-                    cout << "cat: invalid arguments" << endl
-                         << "Usage: cat [filename]" << endl;
-                else
-                    fs.cat(input_vec[1]);
-            }
-
-            // touch
-            else if (input_vec[0] == "touch" || input_vec[0] == "createFile")
-            {
-                if (input_vec.size() != 3)
-                    cout << input_vec[0] << ": invalid arguments" << endl
-                         << "Usage: touch [filename] [filesize_kb]" << endl;
-                else
-                {
-                    try
-                    {
-                        const short filesize_kb = stoi(input_vec[2]);
-                        if (filesize_kb < 0)
-                            cout << input_vec[0] << ": invalid filesize" << endl
-                                 << "Usage: touch [filename] [filesize_kb]" << endl;
-                        else
-                            fs.create_file(input_vec[1], filesize_kb);
-                    }
-                    catch (const exception &e)
-                    {
-                        cout << input_vec[0] << ": invalid filesize" << endl
-                             << "Usage: touch [filename] [filesize_kb]" << endl;
-                    }
-                }
-            }
-
-            // mkdir
-            else if (input_vec[0] == "mkdir" || input_vec[0] == "createDir")
-            {
-                if (input_vec.size() < 2)
-                    // 可以允许多个 dirname 参数
-                    cout << input_vec[0] << ": invalid arguments" << endl
-                         << "Usage: mkdir [dirname1] [dirname2] ..." << endl;
-                else
-                    for (int i = 1; i < input_vec.size(); i++)
-                        fs.create_dir(input_vec[i], 1);
-            }
-
-            // rm
-            else if (input_vec[0] == "rm")
-            {
-                // 允许多个文件/目录参数，能够检测 -r 参数
-                if (input_vec.size() < 2)
-                    cout << input_vec[0] << ": invalid arguments" << endl
-                         << "Usage: rm [-r] [filename1] [filename2] ..." << endl;
-                else
-                {
-                    bool recursive = false;
-                    for (const auto &input : input_vec)
-                        if (input[0] == '-' && input.find("r") != string::npos)
-                        {
-                            recursive = true;
-                            input_vec.erase(remove(input_vec.begin(), input_vec.end(), input), input_vec.end());
-                        }
-
-                    for (int i = 1; i < input_vec.size(); i++)
-                        fs.remove(input_vec[i], recursive);
-                }
-            }
-
-            // cp
-            else if (input_vec[0] == "cp")
-            {
-                // 允许多个文件/目录参数，能够检测 -r 参数
-                if (input_vec.size() < 3)
-                    cout << input_vec[0] << ": invalid arguments" << endl
-                         << "Usage: cp [-r] [src] [dst]" << endl;
-                else
-                {
-                    bool recursive = false;
-                    for (const auto &input : input_vec)
-                        // if (input[0] == '-' && boost::algorithm::contains(input, "r"))
-                        if (input[0] == '-' && input.find("r") != string::npos)
-                        {
-                            recursive = true;
-                            input_vec.erase(remove(input_vec.begin(), input_vec.end(), input), input_vec.end());
-                        }
-
-                    fs.copy(input_vec[1], input_vec[2], recursive);
-                }
-            }
-
-            // ln
-            else if (input_vec[0] == "ln")
-            {
-                if (input_vec.size() != 3)
-                    cout << input_vec[0] << ": invalid arguments" << endl
-                         << "Usage: ln [src] [dst]" << endl;
-                else
-                    fs.hard_link(input_vec[1], input_vec[2]);
-            }
-
-            // stat
-            else if (input_vec[0] == "stat")
-            {
-                if (input_vec.size() != 2)
-                    cout << input_vec[0] << ": invalid arguments" << endl
-                         << "Usage: stat [filename]" << endl;
-                else
-                    fs.stat(input_vec[1]);
-            }
-
-            // sum
-            else if (input_vec[0] == "sum")
-                fs.sum();
-
-            // bitmap / bm
-            else if (input_vec[0] == "bitmap" || input_vec[0] == "bm")
-                fs._show_bitmap();
+        if (input_vec.empty())
+            continue;
 
-            // exit
-            else if (input_vec[0] == "exit")
-                break;
+        const auto start = chrono::steady_clock::now();
+        CommandStatus status = execute_command(fs, input_vec);
+        const auto end = chrono::steady_clock::now();
 
-            else if (input_vec[0] == "clear")
-                system("clear");
-
-            // erase
-            else if (input_vec[0] == "erase")
-            {
-                // 保存原始 cout 缓冲区
-                streambuf *cout_sbuf = cout.rdbuf();
-                // 将 cout 重定向到 /dev/null
-                ofstream devnull("/dev/null");
-                cout.rdbuf(devnull.rdbuf());
-
-                system("rm file.sys");
-                fs = FileSystem();
-
-                // 恢复 cout 到原始缓冲区
-                cout.rdbuf(cout_sbuf);
-                cout << "[Erase] Filesystem erased" << endl;
-            }
-
-            // cmd
-            else if (input_vec[0] == "cmd")
-            {
-                cout << "Available commands:" << endl;
-                cout << "\tl / ls" << endl
-                     << "\t\tList files in current directory" << endl;
-                cout << "\tcd [path]" << endl
-                     << "\t\tChange working directory" << endl;
-                cout << "\tsum" << endl
-                     << "\t\tShow filesystem summary" << endl;
-                cout << "\tcat [filename]" << endl
-                     << "\t\tShow file content" << endl;
-                cout << "\ttouch [filename] [filesize_kb]" << endl
-                     << "\t\tCreate a file" << endl;
-                cout << "\tmkdir [dirname1] [dirname2] ..." << endl
-                     << "\t\tCreate a directory" << endl;
-                cout << "\trm [-r] [filename1] [filename2] ..." << endl
-                     << "\t\tRemove a file or directory" << endl;
-                cout << "\tcp [-r] [src] [dst]" << endl
-                     << "\t\tCopy a file or directory" << endl;
-                cout << "\tln [src] [dst]" << endl
-                     << "\t\tCreate a hard link" << endl;
-                cout << "\tstat [filename]" << endl
-                     << "\t\tShow file INode info" << endl;
-                cout << "\tsum" << endl
-                     << "\t\tShow filesystem summary" << endl;
-                cout << "\tclear" << endl
-                     << "\t\tClear screen" << endl;
-                cout << "\terase" << endl
-                     << "\t\tErase filesystem" << endl;
-                cout << "\texit" << endl
-                     << "\t\tExit" << endl;
-            }
-
-            else if (input_vec[0] == "")
-                ;
+        if (status == CMD_EXIT)
+            break;
 
-            else
-                cout << "command not found: " << input_vec[0] << endl
-                     << "Type 'cmd' to see all available commands" << endl;
-        }
+        // clear 与文件系统无关，不记录
+        if (recorder.is_open() && input_vec[0] != "clear")
+            recorder.append(start, end, status, user_input);
     }
 
     return 0;
@@ -0,0 +1,47 @@
+#!/bin/bash
+# 比较读取压缩文件与未压缩文件的耗时（页缓存已热）：两个镜像中各建一个同样大小的文件，
+# 交替多轮各 cat 若干次，由操作追踪记录每次 cat 的耗时，输出各自的中位数与二者之比
+# 用法：tests/bench_compressed_read.sh <可执行文件> [文件大小，默认 6M] [轮数，默认 5] [每轮 cat 次数，默认 10]
+set -e
+BIN=$(realpath "$1")
+SIZE=${2:-6M}
+ROUNDS=${3:-5}
+CATS=${4:-10}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR"
+
+run()
+{
+    printf '%s\n' "${@:2}" exit | TERM=dumb "$BIN" image "$1".sys "${EXTRA[@]}" >/dev/null 2>&1
+}
+
+EXTRA=()
+run raw erase "touch /f $SIZE"
+EXTRA=(compress)
+run compressed erase "touch /f $SIZE"
+
+# trace.json 中每个事件占一行，取 cat 的开始与结束时间戳（微秒）之差
+cat_times()
+{
+    grep '"name":"cat"' trace.json | sed -E 's/.*"ph":"([BE])","ts":([0-9.]+).*/\1 \2/' |
+        awk '$1 == "B" { begin = $2 } $1 == "E" { printf "%.3f\n", ($2 - begin) / 1000 }'
+}
+
+EXTRA=(trace)
+cats=()
+for ((i = 0; i < CATS; i++)); do cats+=("cat /f"); done
+for ((round = 0; round < ROUNDS; round++)); do
+    for kind in raw compressed; do
+        run $kind "${cats[@]}"
+        cat_times >>$kind.ms
+    done
+done
+
+median()
+{
+    sort -n "$1" | awk '{ v[NR] = $1 } END { print (NR % 2 ? v[(NR + 1) / 2] : (v[NR / 2] + v[NR / 2 + 1]) / 2) }'
+}
+raw=$(median raw.ms)
+compressed=$(median compressed.ms)
+echo "cat $SIZE: raw $raw ms, compressed $compressed ms (median of $((ROUNDS * CATS))), compressed / raw = $(awk -v a="$compressed" -v b="$raw" 'BEGIN { printf "%.2f", a / b }')"
@@ -0,0 +1,49 @@
+#!/bin/bash
+# 工作负载进行中强制结束进程，重新启动后重放日志，元数据与校验和应保持一致
+# 递归复制大量文件时待提交的块超过日志容量，须分多条记录提交
+# 用法：tests/crash_replay.sh <可执行文件> [强制结束前等待的秒数]
+set -e
+BIN=$(realpath "$1")
+DELAY=${2:-1}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR"
+
+run()
+{
+    printf '%s\n' "$@" exit | TERM=dumb "$BIN" 2>&1
+}
+fail()
+{
+    echo "FAIL: $1"
+    exit 1
+}
+
+# 准备 600 个 11K 的文件，正常退出
+cmds=("mkdir /src")
+for i in $(seq 1 600); do
+    cmds+=("touch /src/f$i 11")
+done
+run "${cmds[@]}" > /dev/null
+
+# 回写线程很少定时唤醒且脏块阈值很大，记录按事务数累计提交、日志写满时才做检查点，进程在递归复制与后续命令进行中被强制结束
+mkfifo in
+TERM=dumb "$BIN" d interval 100000 dirty 100000 < in > out 2>&1 &
+pid=$!
+exec 3> in
+printf '%s\n' "cp -r /src /dst" "mkdir /d" "touch /d/a 40" "append /d/a 20" "write /d/a 0 hello" "rm -r /dst" "cp -r /src /dst2" >&3
+sleep "$DELAY"
+{
+    kill -9 $pid
+    wait $pid || true
+} 2> /dev/null
+exec 3>&-
+grep -aq "超过日志容量" out && fail "a commit did not fit in the journal"
+
+# 重新启动：重放已提交的记录，未正常卸载时启动时自动检查，检查应没有发现问题
+out=$(run "fsck" "scrub")
+echo "$out" | grep -q "Replayed [0-9]* committed journal transactions" || fail "no journal transactions were replayed"
+echo "$out" | grep -q "not cleanly unmounted" || fail "mount state was not left dirty by the killed process"
+[ "$(echo "$out" | grep -c "fsck: no problems found")" = 2 ] || fail "fsck found problems after replay: $(echo "$out" | grep "fsck:")"
+echo "$out" | grep -q "scrub: 0 corrupted blocks" || fail "scrub found corrupted blocks after replay"
+echo "PASS"
@@ -0,0 +1,46 @@
+#!/bin/bash
+# 追加或截断有多个硬链接的文件后，各链接所在目录链上的子树用量都要更新
+# 用法：tests/du_hard_links.sh <可执行文件>
+set -e
+BIN=$(realpath "$1")
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR"
+
+run()
+{
+    printf '%s\n' "$@" exit | TERM=dumb "$BIN" 2>&1
+}
+fail()
+{
+    echo "FAIL: $1"
+    exit 1
+}
+blocks()
+{
+    echo "$1" | grep -oE "[0-9]+ blocks +[0-9]+ inodes +$2\$" | awk '{print $1}'
+}
+
+# 4K 的文件追加 100K 后占用 104 个数据块与 1 个间接地址块，/a 中有两个链接
+out=$(run "mkdir /a" "mkdir /b" "touch /a/f 4" "ln /a/f /b/g" "ln /a/f /a/h" "append /b/g 100" "du /a /b" "fsck")
+echo "$out" | grep -q "fsck: no problems found" || fail "fsck disagrees with subtree usage after append"
+[ "$(blocks "$out" /a)" = $((1 + 2 * 105)) ] || fail "du /a is $(blocks "$out" /a) blocks after append"
+[ "$(blocks "$out" /b)" = $((1 + 105)) ] || fail "du /b is $(blocks "$out" /b) blocks after append"
+
+# 截断为 30K 后占用 30 个数据块与 1 个间接地址块
+out=$(run "truncate /a/h 30" "du /a /b" "fsck")
+echo "$out" | grep -q "fsck: no problems found" || fail "fsck disagrees with subtree usage after truncate"
+[ "$(blocks "$out" /b)" = $((1 + 30 + 1)) ] || fail "du /b is $(blocks "$out" /b) blocks after truncate"
+
+# 同一次运行中先追加（构建链接所在目录的记录），再经 ln、mv、rm 改变链接所在的目录后追加，用量仍应与 fsck 一致
+out=$(run "append /a/h 10" "mkdir /c" "ln /a/h /c/k" "mv /a/f /c/f" "mv /c/k /b/g2" "rm /a/h" "append /b/g 20" "du /a /b /c" "fsck")
+echo "$out" | grep -q "fsck: no problems found" || fail "fsck disagrees with subtree usage after links moved"
+[ "$(blocks "$out" /a)" = 1 ] || fail "du /a is $(blocks "$out" /a) blocks after links moved"
+[ "$(blocks "$out" /c)" = $((1 + 60 + 1)) ] || fail "du /c is $(blocks "$out" /c) blocks after links moved"
+run "mv /c/f /a/f" "mv /b/g2 /a/h" "rm -r /c" > /dev/null
+
+# 只剩一个链接时 du / 与 fsck 统计的块数一致
+out=$(run "rm /a/h" "rm /b/g" "du /" "fsck")
+checked=$(echo "$out" | grep -oE "and [0-9]+ blocks" | awk '{print $2}')
+[ "$(blocks "$out" /)" = "$checked" ] || fail "du / is $(blocks "$out" /) blocks, fsck counted $checked"
+echo "PASS"
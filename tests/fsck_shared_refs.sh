@@ -0,0 +1,22 @@
+#!/bin/bash
+# 去重共享超过 255 次的数据块不能被 fsck 误判为未引用
+# 用法：tests/fsck_shared_refs.sh <可执行文件>
+set -e
+BIN=$(realpath "$1")
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR"
+
+# 1 个原始文件 + 255 个副本，去重后每个数据块恰好被引用 256 次
+{
+    echo "touch /a 4"
+    for i in $(seq 1 255); do echo "cp /a /c$i"; done
+    echo "dedup"
+    echo "fsck -y"
+    echo "fsck"
+    echo "exit"
+} | TERM=dumb "$BIN" > out.txt 2>&1
+
+grep -q "fsck: no problems found" out.txt || { echo "FAIL: fsck reported problems"; grep "fsck:" out.txt; exit 1; }
+if grep -q "repaired" out.txt; then echo "FAIL: fsck -y changed a consistent image"; grep "fsck:" out.txt; exit 1; fi
+echo "PASS"
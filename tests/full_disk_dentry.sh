@@ -0,0 +1,46 @@
+#!/bin/bash
+# 磁盘已满时，向 Dentry 数据块均已满的目录新增目录项的命令应报错且不改动文件系统
+# 用法：tests/full_disk_dentry.sh <可执行文件>
+set -e
+BIN=$(realpath "$1")
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR"
+
+run()
+{
+    printf '%s\n' "$@" exit | TERM=dumb "$BIN" 2>&1
+}
+fail()
+{
+    echo "FAIL: $1"
+    exit 1
+}
+
+# /d 与根目录各有 32 个目录项（含 . 与 ..），唯一的 Dentry 数据块已满；/fill 中的文件按递减的大小占满剩余的块
+cmds=("mkdir /d" "mkdir /fill")
+for i in $(seq 1 30); do
+    cmds+=("touch /d/f$i 0")
+done
+for i in $(seq 1 28); do
+    cmds+=("touch /r$i 0")
+done
+i=0
+for size in 4096 4096 4096 2048 1024 512 256 128 64 32 16 8 4 2 1 1 1; do
+    i=$((i + 1))
+    cmds+=("touch /fill/x$i $size")
+done
+out=$(run "${cmds[@]}")
+echo "$out" | grep -q "touch: cannot touch '/fill/x17': No available block" || fail "disk is not full"
+
+out=$(run "touch /d/g 0" "mkdir /d/e" "ln /r1 /d/l" "mv /r1 /d/m" "cp /r1 /d/c" "touch /g 0" "fsck")
+for msg in "touch: cannot touch '/d/g'" "mkdir: cannot create directory '/d/e'" "ln: cannot create link '/d/l'" "mv: cannot move '/r1'" "cp: cannot copy '/r1'" "touch: cannot touch '/g'"; do
+    echo "$out" | grep -q "$msg.*No available block" || fail "expected \"$msg\" to fail with No available block"
+done
+echo "$out" | grep -q "fsck: no problems found" || fail "fsck found problems after commands failed on a full disk"
+
+# 删除一个文件释放出块后，新增目录项可以成功
+out=$(run "rm /fill/x1" "touch /d/g 0" "ls /d" "fsck")
+echo "$out" | grep -q "cannot touch" && fail "touch failed after blocks were freed"
+echo "$out" | grep -q "fsck: no problems found" || fail "fsck found problems after the directory grew"
+echo "PASS"
@@ -0,0 +1,29 @@
+#!/bin/bash
+# 只读取块的一部分（如尾部片段）时也要校验整块，且每块只校验一次
+# 用法：tests/partial_read_checksum.sh <可执行文件>
+set -e
+BIN=$(realpath "$1")
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR"
+
+run()
+{
+    printf '%s\n' "$@" exit | TERM=dumb "$BIN" 2>&1
+}
+fail()
+{
+    echo "FAIL: $1"
+    exit 1
+}
+
+# 1300 字节的文件 /g（INode 1）末尾 276 字节的尾部片段打包在打包块的开头，改动该块中片段之外的字节，
+# 读取时只读取片段本身，也应整块校验并报告，重复读取不再重复校验
+run erase "touch /g 1300B" >/dev/null
+# INode 表从 4KB 处开始，tail_block 位于 INode 内偏移 58 处
+tail_block=$(od -An -td2 -j $((4096 + 128 + 58)) -N2 file.sys | tr -d ' ')
+printf '\x01' | dd of=file.sys bs=1 seek=$((1604 * 1024 + tail_block * 1024 + 1000)) conv=notrunc status=none
+out=$(run "cat /g" "cat /g")
+count=$(echo "$out" | grep -c "data block $tail_block is corrupted" || true)
+[ "$count" = 1 ] || fail "corruption of tail block $tail_block reported $count times"
+echo PASS